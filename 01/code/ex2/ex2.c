@@ -7,9 +7,12 @@
 // General purpose standard C lib
 #include <stdio.h>   // stdio includes printf
 #include <stdlib.h>  // stdlib includes malloc() and free()
+#include <unistd.h>  // unistd includes STDIN_FILENO
 
 // User-defined header files
 #include "node.h"
+#include "reader.h"
+#include "writer.h"
 
 // Macros
 #define PRINT_LIST 0
@@ -19,40 +22,45 @@
 #define REVERSE_LIST 4
 #define RESET_LIST 5
 
-void run_instruction(list *lst, int instr);
+void run_instruction(list *lst, int instr, reader *in);
 void print_list(list *lst);
 
 int main() {
     list *lst = (list *)malloc(sizeof(list));
-    lst->head = NULL;
+    init_list(lst);
 
+    reader in;
+    reader_init(&in, STDIN_FILENO);
     int instr;
-    while (scanf("%d", &instr) == 1) {
-        run_instruction(lst, instr);
+    while (read_op(&in, &instr)) {
+        run_instruction(lst, instr, &in);
     }
 
     reset_list(lst);
     free(lst);
+    reader_close(&in);
+    flush_output();
 }
 
 // Takes an instruction enum and runs the corresponding function
 // We assume input always has the right format (no input validation on runner)
-void run_instruction(list *lst, int instr) {
+void run_instruction(list *lst, int instr, reader *in) {
     int index, data, offset;
     switch (instr) {
         case PRINT_LIST:
             print_list(lst);
             break;
         case INSERT_AT:
-            scanf("%d %d", &index, &data);
+            read_int(in, &index);
+            read_int(in, &data);
             insert_node_at(lst, index, data);
             break;
         case DELETE_AT:
-            scanf("%d", &index);
+            read_int(in, &index);
             delete_node_at(lst, index);
             break;
         case ROTATE_LIST:
-            scanf("%d", &offset);
+            read_int(in, &offset);
             rotate_list(lst, offset);
             break;
         case REVERSE_LIST:
@@ -66,15 +74,16 @@ void run_instruction(list *lst, int instr) {
 // Prints out the whole list in a single line
 void print_list(list *lst) {
     if (lst->head == NULL) {
-        printf("[ ]\n");
+        print_str("[ ]\n");
         return;
     }
 
-    printf("[ ");
+    print_str("[ ");
     node *curr = lst->head;
     do {
-        printf("%d ", curr->data);
-        curr = curr->next;
+        print_int(curr->data);
+        print_char(' ');
+        curr = curr->link[lst->dir];
     } while (curr != lst->head);
-    printf("]\n");
+    print_str("]\n");
 }
@@ -14,22 +14,28 @@
 
 // Add in your implementation below to the respective functions
 // Feel free to add any headers you deem fit (although you do not need to)
-int get_len(node *cur_node) {
-    node *head = cur_node;
-    int len = 1;
-    while (cur_node->next != head) {
-        cur_node = cur_node->next;
-        len++;
-    }
-    return len;
+
+// Sets up an empty list, must be called before any other list function.
+void init_list(list *lst) {
+    lst->head = NULL;
+    lst->len = 0;
+    lst->dir = 0;
 }
 
-node *get_node(node *node, int index) {
-    while (index) {
-        node = node->next;
-        index--;
+// Returns the node at index, walking backwards around the ring when
+// that is shorter.
+static node *get_node(list *lst, int index) {
+    node *cur_node = lst->head;
+    if (index <= lst->len - index) {
+        for (; index; index--) {
+            cur_node = cur_node->link[lst->dir];
+        }
+    } else {
+        for (int steps = lst->len - index; steps; steps--) {
+            cur_node = cur_node->link[!lst->dir];
+        }
     }
-    return node;
+    return cur_node;
 }
 
 // Inserts a new node with data value at index (counting from head
@@ -40,20 +46,24 @@ void insert_node_at(list *lst, int index, int data) {
     new_node->data = data;
     if (!lst->head) {
         lst->head = new_node;
-        lst->head->next = new_node;
+        new_node->link[0] = new_node->link[1] = new_node;
+        lst->len = 1;
         return;
     }
-    int len = get_len(lst->head); // ideally this shd be in the struct.
-    int prev_node_idx = ((index - 1) + len) % len;
-    int next_node_idx = index % len;
-    node *prev_node = get_node(lst->head, prev_node_idx);
-    node *next_node = get_node(lst->head, next_node_idx);
-    prev_node->next = new_node;
-    new_node->next = next_node;
+    int fwd = lst->dir;
+    // goes just before the node currently at index, inserting at len
+    // goes before the head, i.e. after the tail
+    node *next_node = get_node(lst, index % lst->len);
+    node *prev_node = next_node->link[!fwd];
+    new_node->link[fwd] = next_node;
+    new_node->link[!fwd] = prev_node;
+    prev_node->link[fwd] = new_node;
+    next_node->link[!fwd] = new_node;
     // if new_node is first index, update head
     if (!index) {
         lst->head = new_node;
     }
+    lst->len++;
 }
 
 // Deletes node at index (counting from head starting from 0).
@@ -62,19 +72,19 @@ void delete_node_at(list *lst, int index) {
     if (!lst->head) {
         return;
     }
-    int len = get_len(lst->head); // ideally this shd be in the struct.
-    int prev_node_idx = ((index - 1) + len) % len;
-    int next_node_idx = (index + 1) % len;
-    node *prev_node = get_node(lst->head, prev_node_idx);
-    node *next_node = get_node(lst->head, next_node_idx);
-    node *del_node = prev_node->next;
-    prev_node->next = next_node;
+    int fwd = lst->dir;
+    node *del_node = get_node(lst, index);
+    node *next_node = del_node->link[fwd];
+    node *prev_node = del_node->link[!fwd];
+    prev_node->link[fwd] = next_node;
+    next_node->link[!fwd] = prev_node;
     // if index is 0, we need to update the head
     // set head to NULL if its the only node, or to
     // next_node if len is > 1
     if (!index) {
-        lst->head = (len == 1) ? NULL : next_node;
+        lst->head = (lst->len == 1) ? NULL : next_node;
     }
+    lst->len--;
     free(del_node);
 }
 
@@ -84,12 +94,8 @@ void rotate_list(list *lst, int offset) {
     if (!lst->head) {
         return;
     }
-    node *new_head = lst->head;
-    while (offset) {
-        new_head = new_head->next;
-        offset--;
-    }
-    lst->head = new_head;
+    // rotating by len is a no-op so only the remainder matters
+    lst->head = get_node(lst, offset % lst->len);
 }
 
 // Reverses the list, with the original "tail" node
@@ -98,16 +104,8 @@ void reverse_list(list *lst) {
     if (!lst->head) {
         return;
     }
-    node *prev_node = lst->head;
-    node *next_node = prev_node->next;
-    while (next_node != lst->head) {
-        node *tmp = next_node->next;
-        next_node->next = prev_node;
-        prev_node = next_node;
-        next_node = tmp;
-    }
-    next_node->next = prev_node;
-    lst->head = prev_node;
+    lst->head = lst->head->link[!lst->dir];
+    lst->dir = !lst->dir;
 }
 
 // Resets list to an empty state (no nodes) and frees
@@ -116,13 +114,12 @@ void reset_list(list *lst) {
     if (!lst->head) {
         return;
     }
-    node *cur_node = lst->head->next;
+    node *cur_node = lst->head->link[0];
     while (cur_node != lst->head) {
-        node *tmp = cur_node->next;
+        node *tmp = cur_node->link[0];
         free(cur_node);
         cur_node = tmp;
     }
     free(lst->head);
-    lst->head = NULL;
+    init_list(lst);
 }
-
@@ -4,15 +4,22 @@
     during grading so any changes in this file will be overwritten
 */
 
+// The ring is doubly linked and keeps its length, so a positional op
+// walks from the head in whichever direction is shorter. Which link
+// points towards the tail is a property of the list, not the nodes, so
+// reverse_list only flips dir.
 typedef struct NODE {
     int data;
-    struct NODE *next;
+    struct NODE *link[2];   // the two neighbours, see list.dir
 } node;
 
 typedef struct {
     node *head;
+    int len;    // number of nodes in the ring
+    int dir;    // link[dir] runs from head to tail, link[!dir] back
 } list;
 
+void init_list(list *lst);
 void insert_node_at(list *lst, int index, int data);
 void delete_node_at(list *lst, int index);
 void rotate_list(list *lst, int offset);
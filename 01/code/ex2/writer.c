@@ -0,0 +1,115 @@
+/*************************************
+* Lab 1 Exercise 2
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "writer.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define OUT_BLOCKS 16
+#define OUT_BLOCK_SIZE (1 << 16)
+// every append fits in this many bytes, a block with less room left is
+// retired
+#define OUT_SLACK 32
+
+static char blocks[OUT_BLOCKS][OUT_BLOCK_SIZE];
+static struct iovec iov[OUT_BLOCKS];
+static int cur_block = 0;
+static size_t cur_len = 0;
+
+// Writes out every filled block and starts again from the first one.
+void flush_output(void) {
+    iov[cur_block].iov_base = blocks[cur_block];
+    iov[cur_block].iov_len = cur_len;
+    struct iovec *next = iov;
+    int num_iov = cur_block + 1;
+    while (num_iov) {
+        ssize_t wrote = writev(STDOUT_FILENO, next, num_iov);
+        if (wrote < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // the rest of the output can only be lost too
+            perror("Error writing output");
+            exit(1);
+        }
+        // skip whatever was written, a partly written block just shrinks
+        while (num_iov && (size_t) wrote >= next->iov_len) {
+            wrote -= next->iov_len;
+            next++;
+            num_iov--;
+        }
+        if (num_iov) {
+            next->iov_base = (char *) next->iov_base + wrote;
+            next->iov_len -= wrote;
+        }
+    }
+    cur_block = 0;
+    cur_len = 0;
+}
+
+// Returns room for at least OUT_SLACK bytes at the end of the output.
+static char *reserve(void) {
+    if (cur_len > OUT_BLOCK_SIZE - OUT_SLACK) {
+        if (cur_block + 1 == OUT_BLOCKS) {
+            flush_output();
+        } else {
+            iov[cur_block].iov_base = blocks[cur_block];
+            iov[cur_block].iov_len = cur_len;
+            cur_block++;
+            cur_len = 0;
+        }
+    }
+    return blocks[cur_block] + cur_len;
+}
+
+void print_long(long val) {
+    char *out = reserve();
+    char digits[20];
+    int n = 0;
+    unsigned long num = val < 0 ? 0ul - (unsigned long) val : (unsigned long) val;
+    do {
+        digits[n++] = '0' + num % 10;
+        num /= 10;
+    } while (num);
+    if (val < 0) {
+        *out++ = '-';
+        cur_len++;
+    }
+    cur_len += n;
+    while (n) {
+        *out++ = digits[--n];
+    }
+}
+
+void print_int(int val) {
+    print_long(val);
+}
+
+void print_char(char c) {
+    *reserve() = c;
+    cur_len++;
+}
+
+void print_str(const char *str) {
+    while (*str) {
+        char *out = reserve();
+        size_t len = 0;
+        while (str[len] && len < OUT_SLACK) {
+            len++;
+        }
+        memcpy(out, str, len);
+        cur_len += len;
+        str += len;
+    }
+}
@@ -0,0 +1,170 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Checks map_affine with multipliers the runner never produces, zero
+// and negative ones included, against a plain array. Large values make
+// some maps overflow, so both the tagged and the per-value paths run.
+// Snapshots taken along the way must keep their old sums and values.
+//     make check    (or ./affine_test [seed])
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "node.h"
+
+#define OPS 20000
+#define MAX_LEN 2000
+#define NUM_VERSIONS 4
+
+static int model[MAX_LEN];
+static int len = 0;
+
+static int *seen;
+static int num_seen;
+
+static void collect(int data) {
+    seen[num_seen++] = data;
+}
+
+static unsigned int state;
+
+static int rand_below(int n) {
+    state = state * 1103515245u + 12345u;
+    return (int) ((state >> 8) % (unsigned int) n);
+}
+
+static long model_sum(const int *vals, int n) {
+    long sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += vals[i];
+    }
+    return sum;
+}
+
+// Returns 1 if the values of lst (or ver if not NULL) are exactly vals.
+static int same_values(list *lst, const version *ver, const int *vals,
+                       int n) {
+    int got[MAX_LEN + 1];
+    seen = got;
+    num_seen = 0;
+    if (ver) {
+        traverse_version(ver, collect);
+    } else {
+        traverse_list(lst, collect);
+    }
+    if (num_seen != n) {
+        return 0;
+    }
+    for (int i = 0; i < n; i++) {
+        if (got[i] != vals[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    state = argc > 1 ? (unsigned int) atoi(argv[1]) : 2106;
+    list lst;
+    init_list(&lst);
+    version *vers[NUM_VERSIONS] = { NULL };
+    static int ver_vals[NUM_VERSIONS][MAX_LEN];
+    int ver_len[NUM_VERSIONS] = { 0 };
+
+    for (int op = 0; op < OPS; op++) {
+        int r = rand_below(100);
+        if (r < 25 && len < MAX_LEN - 64) {
+            int n = 1 + rand_below(32);
+            int index = rand_below(len + 1);
+            int vals[32];
+            for (int i = 0; i < n; i++) {
+                // small values keep maps in range, large ones overflow
+                vals[i] = rand_below(4) ? rand_below(201) - 100
+                                        : (int) (state * 2654435761u);
+            }
+            insert_many(&lst, index, vals, n);
+            for (int i = len - 1; i >= index; i--) {
+                model[i + n] = model[i];
+            }
+            for (int i = 0; i < n; i++) {
+                model[index + i] = vals[i];
+            }
+            len += n;
+        } else if (r < 35 && len) {
+            int index = rand_below(len);
+            int n = 1 + rand_below(len - index);
+            delete_range(&lst, index, n);
+            for (int i = index; i + n < len; i++) {
+                model[i] = model[i + n];
+            }
+            len -= n;
+        } else if (r < 45 && len) {
+            int offset = rand_below(3 * len);
+            rotate_list(&lst, offset);
+            int tmp[MAX_LEN];
+            for (int i = 0; i < len; i++) {
+                tmp[i] = model[(i + offset) % len];
+            }
+            for (int i = 0; i < len; i++) {
+                model[i] = tmp[i];
+            }
+        } else if (r < 50) {
+            reverse_list(&lst);
+            for (int i = 0, j = len - 1; i < j; i++, j--) {
+                int tmp = model[i];
+                model[i] = model[j];
+                model[j] = tmp;
+            }
+        } else if (r < 80) {
+            int mul = rand_below(7) - 3;
+            int add = rand_below(11) - 5;
+            map_affine(&lst, mul, add);
+            for (int i = 0; i < len; i++) {
+                model[i] = (int) ((unsigned int) mul * (unsigned int) model[i]
+                                  + (unsigned int) add);
+            }
+        } else if (r < 85) {
+            int v = rand_below(NUM_VERSIONS);
+            if (vers[v]) {
+                release_version(vers[v]);
+            }
+            vers[v] = snapshot(&lst);
+            for (int i = 0; i < len; i++) {
+                ver_vals[v][i] = model[i];
+            }
+            ver_len[v] = len;
+        }
+
+        if (sum_list(&lst) != model_sum(model, len)) {
+            fprintf(stderr, "op %d: sum %ld, expected %ld\n", op,
+                    sum_list(&lst), model_sum(model, len));
+            return 1;
+        }
+        if (op % 64 == 0 && !same_values(&lst, NULL, model, len)) {
+            fprintf(stderr, "op %d: list values differ\n", op);
+            return 1;
+        }
+        for (int v = 0; v < NUM_VERSIONS; v++) {
+            if (vers[v] && (sum_version(vers[v])
+                                != model_sum(ver_vals[v], ver_len[v])
+                            || (op % 64 == 0
+                                && !same_values(NULL, vers[v], ver_vals[v],
+                                                ver_len[v])))) {
+                fprintf(stderr, "op %d: version %d differs\n", op, v);
+                return 1;
+            }
+        }
+    }
+    for (int v = 0; v < NUM_VERSIONS; v++) {
+        if (vers[v]) {
+            release_version(vers[v]);
+        }
+    }
+    reset_list(&lst);
+    printf("affine_test ok\n");
+    return 0;
+}
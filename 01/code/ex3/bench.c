@@ -0,0 +1,149 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Replays a trace (text or binary) straight against node.c and reports
+// throughput, the mean time per op type and peak RSS. SUM_LIST results
+// are folded into a checksum instead of printed. Compile with different
+// NODE_CAP values to compare layouts on the same trace.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "function_pointers.h"
+#include "node.h"
+#include "reader.h"
+
+// Macros
+#define SUM_LIST 0
+#define INSERT_AT 1
+#define DELETE_AT 2
+#define ROTATE_LIST 3
+#define REVERSE_LIST 4
+#define RESET_LIST 5
+#define MAP 6
+#define INSERT_MANY 7
+#define DELETE_RANGE 8
+#define DUMP_STATS 9
+#define NUM_OPS 10
+
+static const char *op_names[NUM_OPS] = {
+    "SUM_LIST", "INSERT_AT", "DELETE_AT", "ROTATE_LIST",
+    "REVERSE_LIST", "RESET_LIST", "MAP", "INSERT_MANY", "DELETE_RANGE",
+    "DUMP_STATS"
+};
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <trace>\n", argv[0]);
+        exit(1);
+    }
+    reader in;
+    if (!reader_open(&in, argv[1])) {
+        fprintf(stderr, "Error reading file %s\n", argv[1]);
+        exit(1);
+    }
+    update_functions();
+
+    list *lst = (list *)malloc(sizeof(list));
+    init_list(lst);
+    long op_count[NUM_OPS] = { 0 };
+    long op_ns[NUM_OPS] = { 0 };
+    long checksum = 0;
+    int *values = NULL;
+    int values_cap = 0;
+    int op, index, data, count;
+    long start = now_ns();
+    while (read_op(&in, &op)) {
+        if (op < 0 || op >= NUM_OPS) {
+            fprintf(stderr, "Unknown opcode %d\n", op);
+            exit(1);
+        }
+        if (op == INSERT_AT) {
+            read_int(&in, &index);
+            read_int(&in, &data);
+        } else if (op == DELETE_AT || op == ROTATE_LIST || op == MAP) {
+            read_int(&in, &index);
+        } else if (op == INSERT_MANY || op == DELETE_RANGE) {
+            read_int(&in, &index);
+            read_int(&in, &count);
+        }
+        if (op == INSERT_MANY) {
+            if (count > values_cap) {
+                values_cap = count;
+                values = (int *) realloc(values, values_cap * sizeof(int));
+            }
+            for (int i = 0; i < count; i++) {
+                read_int(&in, &values[i]);
+            }
+        }
+        long op_start = now_ns();
+        switch (op) {
+            case SUM_LIST:
+                checksum += sum_list(lst);
+                break;
+            case INSERT_AT:
+                insert_node_at(lst, index, data);
+                break;
+            case DELETE_AT:
+                delete_node_at(lst, index);
+                break;
+            case ROTATE_LIST:
+                rotate_list(lst, index);
+                break;
+            case REVERSE_LIST:
+                reverse_list(lst);
+                break;
+            case RESET_LIST:
+                reset_list(lst);
+                break;
+            case INSERT_MANY:
+                insert_many(lst, index, values, count);
+                break;
+            case DELETE_RANGE:
+                delete_range(lst, index, count);
+                break;
+            case DUMP_STATS:
+                dump_list_stats();
+                break;
+            default:
+                map(lst, func_list[index]);
+        }
+        op_ns[op] += now_ns() - op_start;
+        op_count[op]++;
+    }
+    long total_ns = now_ns() - start;
+
+    long total_ops = 0;
+    for (int i = 0; i < NUM_OPS; i++) {
+        total_ops += op_count[i];
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("NODE_CAP=%d %s: %ld ops in %.3f s, %.0f ops/sec,"
+           " peak RSS %ld KB, checksum %ld\n", NODE_CAP, argv[1], total_ops,
+           total_ns / 1e9, total_ops / (total_ns / 1e9), usage.ru_maxrss,
+           checksum);
+    for (int i = 0; i < NUM_OPS; i++) {
+        if (op_count[i]) {
+            printf("  %-12s %10ld calls %12.1f ns/op\n", op_names[i],
+                   op_count[i], (double) op_ns[i] / op_count[i]);
+        }
+    }
+    reset_list(lst);
+    free(lst);
+    free(values);
+    reader_close(&in);
+}
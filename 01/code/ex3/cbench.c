@@ -0,0 +1,136 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Scaling benchmark for clist: for every thread count from 1 up to the
+// given maximum, times an append-only ingest and a mix of positional
+// inserts, deletes and sums on one shared list, then checks the
+// atomically kept sum and length against a full traversal.
+//     ./cbench [max threads] [ops per thread] [initial length]
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "clist.h"
+
+typedef struct {
+    clist *lst;
+    int ops;
+    int mixed;          // 0 for append only
+    unsigned int seed;
+} worker_args;
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// xorshift32, one state per thread
+static unsigned int next_rand(unsigned int *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void *worker(void *arg) {
+    worker_args *w = (worker_args *) arg;
+    unsigned int state = w->seed;
+    long sink = 0;
+    for (int i = 0; i < w->ops; i++) {
+        unsigned int r = next_rand(&state);
+        int data = (int) (r % 2001) - 1000;
+        if (!w->mixed) {
+            clist_append(w->lst, data);
+            continue;
+        }
+        // the length may change under us, clist clamps stale indices
+        int len = clist_len(w->lst);
+        switch (r % 10) {
+            case 0:
+                sink += clist_sum(w->lst);
+                break;
+            case 1: case 2: case 3: case 4: case 5:
+                clist_insert_at(w->lst, next_rand(&state) % (len + 1), data);
+                break;
+            default:
+                clist_delete_at(w->lst, len ? next_rand(&state) % len : 0);
+        }
+    }
+    return (void *) sink;
+}
+
+static long checked_sum;
+static int checked_len;
+
+static void check_value(int data) {
+    checked_sum += data;
+    checked_len++;
+}
+
+// Runs num_threads workers against lst, returns the elapsed seconds.
+static double run(clist *lst, int num_threads, int ops, int mixed) {
+    pthread_t tids[num_threads];
+    worker_args args[num_threads];
+    long start = now_ns();
+    for (int t = 0; t < num_threads; t++) {
+        args[t].lst = lst;
+        args[t].ops = ops;
+        args[t].mixed = mixed;
+        args[t].seed = 2106u + 7919u * t;
+        pthread_create(&tids[t], NULL, worker, &args[t]);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    double secs = (now_ns() - start) / 1e9;
+
+    checked_sum = 0;
+    checked_len = 0;
+    clist_traverse(lst, check_value);
+    if (checked_sum != clist_sum(lst) || checked_len != clist_len(lst)) {
+        fprintf(stderr, "Mismatch: traversal %ld/%d, counters %ld/%d\n",
+                checked_sum, checked_len, clist_sum(lst), clist_len(lst));
+        exit(1);
+    }
+    return secs;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+    int ops = argc > 2 ? atoi(argv[2]) : 100000;
+    int init_len = argc > 3 ? atoi(argv[3]) : 10000;
+    if (max_threads < 1 || ops < 1 || init_len < 0) {
+        fprintf(stderr, "Usage: %s [max threads] [ops per thread]"
+                " [initial length]\n", argv[0]);
+        exit(1);
+    }
+    printf("%7s %16s %16s\n", "threads", "ingest ops/sec", "mixed ops/sec");
+    for (int t = 1; t <= max_threads; t++) {
+        clist lst;
+        clist_init(&lst);
+        double ingest = run(&lst, t, ops, 0);
+        if (clist_len(&lst) != t * ops) {
+            fprintf(stderr, "Lost appends: %d of %d\n", clist_len(&lst),
+                    t * ops);
+            exit(1);
+        }
+        clist_destroy(&lst);
+
+        clist_init(&lst);
+        for (int i = 0; i < init_len; i++) {
+            clist_append(&lst, i % 2001 - 1000);
+        }
+        double mixed = run(&lst, t, ops, 1);
+        clist_destroy(&lst);
+
+        printf("%7d %16.0f %16.0f\n", t, t * ops / ingest, t * ops / mixed);
+    }
+}
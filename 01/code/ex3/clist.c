@@ -0,0 +1,250 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#include "clist.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static chunk *new_chunk(void) {
+    chunk *c = (chunk *) malloc(sizeof(chunk));
+    pthread_mutex_init(&c->lock, NULL);
+    c->cnt = 0;
+    c->dead = 0;
+    c->next = NULL;
+    c->retired = NULL;
+    return c;
+}
+
+static void lock(chunk *c) {
+    pthread_mutex_lock(&c->lock);
+}
+
+static void unlock(chunk *c) {
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Every changed value goes through here so the lock-free readers of sum
+// and len never see a torn update.
+static void account(clist *lst, long sum, int len) {
+    __atomic_fetch_add(&lst->sum, sum, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&lst->len, len, __ATOMIC_RELAXED);
+}
+
+// Only the holder of the tail chunk's lock may move the tail, so a
+// thread holding c's lock can trust is_tail(lst, c).
+static int is_tail(clist *lst, chunk *c) {
+    return __atomic_load_n(&lst->tail, __ATOMIC_ACQUIRE) == c;
+}
+
+static void set_tail(clist *lst, chunk *c) {
+    __atomic_store_n(&lst->tail, c, __ATOMIC_RELEASE);
+}
+
+// Sets up an empty list, must be called before any other clist function.
+void clist_init(clist *lst) {
+    pthread_mutex_init(&lst->head.lock, NULL);
+    lst->head.cnt = 0;
+    lst->head.dead = 0;
+    lst->head.next = NULL;
+    lst->head.retired = NULL;
+    lst->tail = &lst->head;
+    lst->sum = 0;
+    lst->len = 0;
+    pthread_mutex_init(&lst->retired_lock, NULL);
+    lst->retired = NULL;
+}
+
+// Frees every chunk. No other thread may be using the list.
+void clist_destroy(clist *lst) {
+    chunk *c = lst->head.next;
+    while (c) {
+        chunk *tmp = c->next;
+        pthread_mutex_destroy(&c->lock);
+        free(c);
+        c = tmp;
+    }
+    c = lst->retired;
+    while (c) {
+        chunk *tmp = c->retired;
+        pthread_mutex_destroy(&c->lock);
+        free(c);
+        c = tmp;
+    }
+    pthread_mutex_destroy(&lst->head.lock);
+    pthread_mutex_destroy(&lst->retired_lock);
+}
+
+// Walks from the sentinel to the chunk holding index, or the one an
+// insert at index goes into if inserting is set. On return *prev and
+// the returned chunk are locked and *index is relative to the chunk. If
+// index is past the end, NULL is returned with only *prev, the last
+// chunk, still locked.
+static chunk *walk(clist *lst, int *index, int inserting, chunk **prev) {
+    chunk *p = &lst->head;
+    lock(p);
+    chunk *cur = p->next;
+    while (cur) {
+        lock(cur);
+        if (*index < cur->cnt || (inserting && *index == cur->cnt)) {
+            break;
+        }
+        *index -= cur->cnt;
+        unlock(p);
+        p = cur;
+        cur = cur->next;
+    }
+    *prev = p;
+    return cur;
+}
+
+// Inserts data at index (counting from the head starting at 0).
+void clist_insert_at(clist *lst, int index, int data) {
+    chunk *prev;
+    chunk *cur = walk(lst, &index, 1, &prev);
+    if (!cur) {
+        // past the end, so it goes after the last chunk
+        cur = prev;
+        index = cur->cnt;
+        prev = NULL;
+    }
+    chunk *extra = NULL;
+    if (cur == &lst->head || cur->cnt == CLIST_CAP) {
+        // split the upper half into a new chunk (or start the first
+        // one), locked before anyone can reach it through tail
+        extra = new_chunk();
+        lock(extra);
+        int half = cur->cnt / 2;
+        extra->cnt = cur->cnt - half;
+        memcpy(extra->data, cur->data + half, extra->cnt * sizeof(int));
+        cur->cnt = half;
+        extra->next = cur->next;
+        cur->next = extra;
+        if (is_tail(lst, cur)) {
+            set_tail(lst, extra);
+        }
+    }
+    chunk *target = cur;
+    if (extra && (index > cur->cnt || cur == &lst->head)) {
+        target = extra;
+        index -= cur->cnt;
+    }
+    memmove(target->data + index + 1, target->data + index,
+            (target->cnt - index) * sizeof(int));
+    target->data[index] = data;
+    target->cnt++;
+    account(lst, data, 1);
+    if (extra) {
+        unlock(extra);
+    }
+    unlock(cur);
+    if (prev) {
+        unlock(prev);
+    }
+}
+
+// Deletes the value at index (counting from the head starting at 0),
+// returns 0 if there is no such value.
+int clist_delete_at(clist *lst, int index) {
+    chunk *prev;
+    chunk *cur = walk(lst, &index, 0, &prev);
+    if (!cur) {
+        unlock(prev);
+        return 0;
+    }
+    int data = cur->data[index];
+    memmove(cur->data + index, cur->data + index + 1,
+            (cur->cnt - index - 1) * sizeof(int));
+    cur->cnt--;
+    account(lst, -data, -1);
+    if (!cur->cnt) {
+        // unlink, but leave freeing to clist_destroy
+        prev->next = cur->next;
+        if (is_tail(lst, cur)) {
+            set_tail(lst, prev);
+        }
+        cur->dead = 1;
+        pthread_mutex_lock(&lst->retired_lock);
+        cur->retired = lst->retired;
+        lst->retired = cur;
+        pthread_mutex_unlock(&lst->retired_lock);
+    }
+    unlock(cur);
+    unlock(prev);
+    return 1;
+}
+
+// Adds data after the last value without walking the chain.
+void clist_append(clist *lst, int data) {
+    chunk *t;
+    for (;;) {
+        t = __atomic_load_n(&lst->tail, __ATOMIC_ACQUIRE);
+        lock(t);
+        // the tail may have been split or unlinked since it was read
+        if (!t->dead && !t->next) {
+            break;
+        }
+        unlock(t);
+    }
+    if (t == &lst->head || t->cnt == CLIST_CAP) {
+        chunk *c = new_chunk();
+        c->data[0] = data;
+        c->cnt = 1;
+        t->next = c;
+        set_tail(lst, c);
+    } else {
+        t->data[t->cnt++] = data;
+    }
+    account(lst, data, 1);
+    unlock(t);
+}
+
+// Replaces every value x with func(x), one chunk at a time.
+void clist_map(clist *lst, int (*func)(int)) {
+    chunk *prev = &lst->head;
+    lock(prev);
+    chunk *cur = prev->next;
+    while (cur) {
+        lock(cur);
+        unlock(prev);
+        long delta = 0;
+        for (int i = 0; i < cur->cnt; i++) {
+            int val = (*func)(cur->data[i]);
+            delta += (long) val - cur->data[i];
+            cur->data[i] = val;
+        }
+        account(lst, delta, 0);
+        prev = cur;
+        cur = cur->next;
+    }
+    unlock(prev);
+}
+
+long clist_sum(clist *lst) {
+    return __atomic_load_n(&lst->sum, __ATOMIC_RELAXED);
+}
+
+int clist_len(clist *lst) {
+    return __atomic_load_n(&lst->len, __ATOMIC_RELAXED);
+}
+
+// Calls visit on every value from head to tail.
+void clist_traverse(clist *lst, void (*visit)(int)) {
+    chunk *prev = &lst->head;
+    lock(prev);
+    chunk *cur = prev->next;
+    while (cur) {
+        lock(cur);
+        unlock(prev);
+        for (int i = 0; i < cur->cnt; i++) {
+            (*visit)(cur->data[i]);
+        }
+        prev = cur;
+        cur = cur->next;
+    }
+    unlock(prev);
+}
@@ -0,0 +1,54 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#include <pthread.h>
+
+// A list that any number of threads can drive at once. Values are packed
+// CLIST_CAP to a chunk and the chunks form a singly linked chain behind a
+// sentinel. Every chunk has its own lock.
+//
+// Positional ops lock their way down the chain hand over hand, always
+// holding the previous chunk as well as the current one. So an op can
+// never overtake one that set off from the sentinel before it, and every
+// op sees the list as all earlier ops left it. clist_append locks the
+// tail chunk directly and skips the walk. The sum and length are kept
+// up to date with atomics, so reading them takes no lock at all.
+//
+// Chunks that empty out are unlinked but only freed by clist_destroy, as
+// an appender may still be holding on to a stale tail pointer.
+#define CLIST_CAP 64
+
+typedef struct CHUNK {
+    pthread_mutex_t lock;
+    int cnt;                // number of values packed in data
+    int dead;               // 1 once unlinked from the chain
+    struct CHUNK *next;
+    struct CHUNK *retired;  // next unlinked chunk waiting to be freed
+    int data[CLIST_CAP];
+} chunk;
+
+typedef struct {
+    chunk head;             // sentinel, never holds values
+    chunk *tail;            // last chunk, the sentinel if empty
+    long sum;               // sum of every value, updated atomically
+    int len;                // number of values, updated atomically
+    pthread_mutex_t retired_lock;
+    chunk *retired;         // unlinked chunks
+} clist;
+
+void clist_init(clist *lst);
+void clist_destroy(clist *lst);
+
+// An index past the end inserts at the end, deleting past the end
+// does nothing and returns 0.
+void clist_insert_at(clist *lst, int index, int data);
+int clist_delete_at(clist *lst, int index);
+void clist_append(clist *lst, int data);
+void clist_map(clist *lst, int (*func)(int));
+long clist_sum(clist *lst);
+int clist_len(clist *lst);
+void clist_traverse(clist *lst, void (*visit)(int));
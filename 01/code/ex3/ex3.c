@@ -5,11 +5,15 @@
 * Lab Group: 06
 *************************************/
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "function_pointers.h"
+#include "kernels.h"
 #include "node.h"
+#include "reader.h"
+#include "writer.h"
 
 // The runner is empty now! Modify it to fulfill the requirements of the
 // exercise. You can use ex2.c as a template
@@ -25,8 +29,24 @@
 #define REVERSE_LIST 4
 #define RESET_LIST 5
 #define MAP 6
+#define INSERT_MANY 7
+#define DELETE_RANGE 8
+#define DUMP_STATS 9
 
-void run_instruction(list*, int, FILE*);
+// MAPs are not applied straight away: they queue up here and run as one
+// fused pass when something needs the values. Runs of affine maps are
+// composed into a single mul/add step.
+#define MAX_PENDING_MAPS 64
+
+static map_step pending_maps[MAX_PENDING_MAPS];
+static int num_pending_maps = 0;
+
+// Values of the INSERT_MANY being run, grown as needed
+static int *bulk_values = NULL;
+static int bulk_cap = 0;
+
+void run_instruction(list*, int, reader*);
+void print_list(list *lst);
 
 int main(int argc, char **argv) {
     if (argc != 2) {
@@ -44,70 +64,139 @@ int main(int argc, char **argv) {
 
     // Rest of code logic here
     // open file and read
-    FILE* fp;
-    fp = fopen(fname, "r");
-    if (fp == NULL) {
+    reader in;
+    if (!reader_open(&in, fname)) {
         printf("Error reading file %s\n.", fname);
         exit(1);
     }
     // declare list
     list *lst = (list *)malloc(sizeof(list));
-    lst->head = NULL;
+    init_list(lst);
     int instr;
-    while (fscanf(fp, "%d", &instr) == 1) {
-        run_instruction(lst, instr, fp);
+    while (read_op(&in, &instr)) {
+        run_instruction(lst, instr, &in);
     }
     reset_list(lst);
     free(lst);
-    fclose(fp);
+    free(bulk_values);
+    reader_close(&in);
+    flush_output();
+    // only prints anything when built with -DLIST_STATS
+    dump_list_stats();
+}
+
+// Applies the queued maps to the list.
+static void flush_maps(list *lst) {
+    if (num_pending_maps == 1 && !pending_maps[0].func) {
+        map_affine(lst, pending_maps[0].mul, pending_maps[0].add);
+    } else if (num_pending_maps) {
+        map_steps(lst, pending_maps, num_pending_maps);
+    }
+    num_pending_maps = 0;
+}
+
+// Queues func, folding it into the previous step if both are affine and
+// the composed coefficients still fit in an int.
+static void defer_map(list *lst, int (*func)(int)) {
+    int mul = 1, add = 0;
+    if (kernel_affine(kernel_for(func), &mul, &add)) {
+        if (num_pending_maps && !pending_maps[num_pending_maps - 1].func) {
+            map_step *last = &pending_maps[num_pending_maps - 1];
+            long new_mul = 1L * mul * last->mul;
+            long new_add = 1L * mul * last->add + add;
+            if (new_mul >= INT_MIN && new_mul <= INT_MAX
+                && new_add >= INT_MIN && new_add <= INT_MAX) {
+                last->mul = (int) new_mul;
+                last->add = (int) new_add;
+                return;
+            }
+        }
+        func = NULL;
+    }
+    if (num_pending_maps == MAX_PENDING_MAPS) {
+        flush_maps(lst);
+    }
+    map_step step = { func, mul, add };
+    pending_maps[num_pending_maps++] = step;
 }
 
 // Takes an instruction enum and runs the corresponding function
 // We assume input always has the right format (no input validation on runner)
-void run_instruction(list *lst, int instr, FILE* fp) {
-    int index, data, offset;
+void run_instruction(list *lst, int instr, reader *in) {
+    int index, data, offset, count;
     long sum = 0;
     switch (instr) {
         case SUM_LIST:
+            flush_maps(lst);
             sum = sum_list(lst);
-            printf("%ld\n", sum);
+            print_long(sum);
+            print_char('\n');
             break;
         case INSERT_AT:
-            fscanf(fp, "%d %d", &index, &data);
+            read_int(in, &index);
+            read_int(in, &data);
+            // the new value must not see the maps queued before it
+            flush_maps(lst);
             insert_node_at(lst, index, data);
             break;
         case DELETE_AT:
-            fscanf(fp, "%d", &index);
+            read_int(in, &index);
             delete_node_at(lst, index);
             break;
+        case INSERT_MANY:
+            read_int(in, &index);
+            read_int(in, &count);
+            if (count > bulk_cap) {
+                bulk_cap = count;
+                bulk_values = (int *) realloc(bulk_values,
+                                              bulk_cap * sizeof(int));
+            }
+            for (int i = 0; i < count; i++) {
+                read_int(in, &bulk_values[i]);
+            }
+            flush_maps(lst);
+            insert_many(lst, index, bulk_values, count);
+            break;
+        case DELETE_RANGE:
+            read_int(in, &index);
+            read_int(in, &count);
+            delete_range(lst, index, count);
+            break;
+        case DUMP_STATS:
+            flush_output();
+            dump_list_stats();
+            break;
         case ROTATE_LIST:
-            fscanf(fp, "%d", &offset);
+            read_int(in, &offset);
             rotate_list(lst, offset);
             break;
         case REVERSE_LIST:
             reverse_list(lst);
             break;
         case RESET_LIST:
+            num_pending_maps = 0;
             reset_list(lst);
             break;
         case MAP:
-            fscanf(fp, "%d", &index);
-            map(lst, func_list[index]);
+            read_int(in, &index);
+            defer_map(lst, func_list[index]);
     }
 }
 
+static void print_data(int data) {
+    print_int(data);
+    print_char(' ');
+}
+
 // Prints out the whole list in a single line
 void print_list(list *lst) {
-    if (lst->head == NULL) {
-        printf("[ ]\n");
+    flush_maps(lst);
+    if (lst->root == NULL) {
+        print_str("[ ]\n");
         return;
     }
 
-    printf("[ ");
-    node *curr = lst->head;
-    do {
-        printf("%d ", curr->data);
-        curr = curr->next;
-    } while (curr != lst->head);
-    printf("]\n");
+    print_str("[ ");
+    traverse_list(lst, print_data);
+    print_str("]\n");
 }
@@ -0,0 +1,209 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Writes a reproducible synthetic trace in the ex3 text format to stdout.
+//     -n ops     number of instructions after the initial fill
+//     -l len     list length to fill up to before the mixed ops
+//     -m mix     weights for SUM:INSERT:DELETE:ROTATE:REVERSE:RESET:MAP,
+//                optionally followed by :INSERT_MANY:DELETE_RANGE
+//     -k bulk    most values moved by one INSERT_MANY or DELETE_RANGE
+//     -d dist    index distribution: uniform, head or tail
+//     -s seed    PRNG seed, the same seed always gives the same trace
+//     -q lists   spread the ops over this many lists, tagging every
+//                instruction with its list id as mex3 expects
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Macros
+#define INSERT_AT 1
+#define DELETE_AT 2
+#define ROTATE_LIST 3
+#define RESET_LIST 5
+#define MAP 6
+#define INSERT_MANY 7
+#define DELETE_RANGE 8
+#define NUM_OPS 9
+#define NUM_BASE_OPS 7
+
+#define DIST_UNIFORM 0
+#define DIST_HEAD 1
+#define DIST_TAIL 2
+
+static unsigned long rng_state;
+
+// xorshift64*, so traces do not depend on the libc rand()
+static unsigned long next_rand(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ul;
+}
+
+// Returns a value in [0, bound).
+static long rand_below(long bound) {
+    return (long) (next_rand() % (unsigned long) bound);
+}
+
+// Picks an index in [0, bound) following dist. The skewed distributions
+// cube a uniform draw so most indices land near one end.
+static long pick_index(long bound, int dist) {
+    if (dist == DIST_UNIFORM) {
+        return rand_below(bound);
+    }
+    double u = (next_rand() >> 11) * (1.0 / 9007199254740992.0);
+    long idx = (long) (u * u * u * bound);
+    return dist == DIST_HEAD ? idx : bound - 1 - idx;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n ops] [-l len]"
+            " [-m s:i:d:rot:rev:reset:map[:imany:drange]] [-k bulk]"
+            " [-d uniform|head|tail] [-s seed] [-q lists]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    long num_ops = 200000;
+    long fill_len = 100000;
+    int weights[NUM_OPS] = { 10, 40, 30, 5, 5, 0, 1, 0, 0 };
+    long bulk = 64;
+    long num_lists = 0;
+    int dist = DIST_UNIFORM;
+    rng_state = 2106;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:m:k:d:s:q:")) != -1) {
+        switch (opt) {
+            case 'n':
+                num_ops = atol(optarg);
+                break;
+            case 'l':
+                fill_len = atol(optarg);
+                break;
+            case 'm':
+                weights[7] = weights[8] = 0;
+                if (sscanf(optarg, "%d:%d:%d:%d:%d:%d:%d:%d:%d", &weights[0],
+                           &weights[1], &weights[2], &weights[3], &weights[4],
+                           &weights[5], &weights[6], &weights[7],
+                           &weights[8]) < NUM_BASE_OPS) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'k':
+                bulk = atol(optarg);
+                if (bulk < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'd':
+                if (!strcmp(optarg, "uniform")) {
+                    dist = DIST_UNIFORM;
+                } else if (!strcmp(optarg, "head")) {
+                    dist = DIST_HEAD;
+                } else if (!strcmp(optarg, "tail")) {
+                    dist = DIST_TAIL;
+                } else {
+                    usage(argv[0]);
+                }
+                break;
+            case 'q':
+                num_lists = atol(optarg);
+                if (num_lists < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 's':
+                // xorshift must not start from 0
+                rng_state = strtoul(optarg, NULL, 10) | 1;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    int total_weight = 0;
+    for (int i = 0; i < NUM_OPS; i++) {
+        total_weight += weights[i];
+    }
+    if (total_weight <= 0) {
+        usage(argv[0]);
+    }
+
+    // untagged traces are one list
+    long *lens = (long *) calloc(num_lists ? num_lists : 1, sizeof(long));
+    for (long i = 0; i < fill_len; i++) {
+        long l = num_lists ? rand_below(num_lists) : 0;
+        if (num_lists) {
+            printf("%ld ", l);
+        }
+        printf("%d %ld %ld\n", INSERT_AT, pick_index(lens[l] + 1, dist),
+               rand_below(2001) - 1000);
+        lens[l]++;
+    }
+    for (long i = 0; i < num_ops; i++) {
+        long l = num_lists ? rand_below(num_lists) : 0;
+        long len = lens[l];
+        if (num_lists) {
+            printf("%ld ", l);
+        }
+        int roll = (int) rand_below(total_weight);
+        int op = 0;
+        while (roll >= weights[op]) {
+            roll -= weights[op++];
+        }
+        // an empty list cannot lose values, grow it instead
+        if ((op == DELETE_AT || op == DELETE_RANGE) && !len) {
+            op = INSERT_AT;
+        }
+        switch (op) {
+            case INSERT_AT:
+                printf("%d %ld %ld\n", op, pick_index(len + 1, dist),
+                       rand_below(2001) - 1000);
+                len++;
+                break;
+            case DELETE_AT:
+                printf("%d %ld\n", op, pick_index(len, dist));
+                len--;
+                break;
+            case INSERT_MANY: {
+                long index = pick_index(len + 1, dist);
+                long count = 1 + rand_below(bulk);
+                printf("%d %ld %ld", op, index, count);
+                for (long k = 0; k < count; k++) {
+                    printf(" %ld", rand_below(2001) - 1000);
+                }
+                putchar('\n');
+                len += count;
+                break;
+            }
+            case DELETE_RANGE: {
+                long count = 1 + rand_below(bulk < len ? bulk : len);
+                printf("%d %ld %ld\n", op, pick_index(len - count + 1, dist),
+                       count);
+                len -= count;
+                break;
+            }
+            case ROTATE_LIST:
+                printf("%d %ld\n", op, rand_below(1000000000));
+                break;
+            case RESET_LIST:
+                printf("%d\n", op);
+                len = 0;
+                break;
+            case MAP:
+                printf("%d %ld\n", op, rand_below(5));
+                break;
+            default:
+                printf("%d\n", op);
+        }
+        lens[l] = len;
+    }
+    free(lens);
+}
@@ -0,0 +1,238 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#include "kernels.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "functions.h"
+
+#if defined(__SSE2__) && !defined(NO_SIMD)
+#define USE_SIMD
+#include <immintrin.h>
+#endif
+
+// Returns the kernel id for func, or KERNEL_NONE if it is not one of the
+// transforms in functions.c.
+int kernel_for(int (*func)(int)) {
+#define FIND_KERNEL(name, fn, m, a, expr)   \
+    if (func == fn) {                       \
+        return KERNEL_##name;               \
+    }
+    KERNEL_TABLE(FIND_KERNEL)
+#undef FIND_KERNEL
+    return KERNEL_NONE;
+}
+
+// If kernel is x -> mul * x + add, stores the coefficients and returns 1.
+int kernel_affine(int kernel, int *mul, int *add) {
+    switch (kernel) {
+#define AFFINE_CASE(name, fn, m, a, expr)   \
+        case KERNEL_##name:                 \
+            if (!(m)) {                     \
+                return 0;                   \
+            }                               \
+            *mul = m;                       \
+            *add = a;                       \
+            return 1;
+        KERNEL_TABLE(AFFINE_CASE)
+#undef AFFINE_CASE
+        default:
+            return 0;
+    }
+}
+
+static long sum_scalar(const int *data, int n) {
+    long sum = 0L;
+    for (int i = 0; i < n; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+static void affine_scalar(int *data, int n, unsigned int mul,
+                          unsigned int add) {
+    for (int i = 0; i < n; i++) {
+        data[i] = (int) ((unsigned int) data[i] * mul + add);
+    }
+}
+
+#ifdef USE_SIMD
+static long sum_sse2(const int *data, int n) {
+    __m128i acc = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        // sign extend to 64 bits by interleaving with the sign mask
+        __m128i sign = _mm_srai_epi32(v, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, sign));
+    }
+    long lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, acc);
+    return lanes[0] + lanes[1] + sum_scalar(data + i, n - i);
+}
+
+// SSE2 has no 32-bit mullo, so multiply the even and odd lanes separately
+static __m128i mullo_sse2(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static void affine_sse2(int *data, int n, unsigned int mul,
+                        unsigned int add) {
+    __m128i m = _mm_set1_epi32((int) mul);
+    __m128i a = _mm_set1_epi32((int) add);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+        v = _mm_add_epi32(mullo_sse2(v, m), a);
+        _mm_storeu_si128((__m128i *) (data + i), v);
+    }
+    affine_scalar(data + i, n - i, mul, add);
+}
+
+__attribute__((target("avx2")))
+static long sum_avx2(const int *data, int n) {
+    __m256i acc = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) (data + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *) (data + i + 4));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(lo));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(hi));
+    }
+    long lanes[4];
+    _mm256_storeu_si256((__m256i *) lanes, acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3]
+           + sum_scalar(data + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void affine_avx2(int *data, int n, unsigned int mul,
+                        unsigned int add) {
+    __m256i m = _mm256_set1_epi32((int) mul);
+    __m256i a = _mm256_set1_epi32((int) add);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (data + i));
+        v = _mm256_add_epi32(_mm256_mullo_epi32(v, m), a);
+        _mm256_storeu_si256((__m256i *) (data + i), v);
+    }
+    affine_scalar(data + i, n - i, mul, add);
+}
+#endif
+
+// The map loops are stamped out per kernel and per instruction set from
+// the expression in KERNEL_TABLE: on a plain unsigned int for the scalar
+// loop, and on GCC vector types for the SSE2 and AVX2 ones. Each loop
+// has its transform inlined, so map_ints dispatches once per call
+// rather than once per value. Unsigned arithmetic gives the same
+// results as functions.c, but overflow wraps instead of being undefined.
+#define MAP_SCALAR(name, fn, m, a, expr)                    \
+    static void map_##name##_scalar(int *data, int n) {     \
+        for (int i = 0; i < n; i++) {                       \
+            unsigned int u = (unsigned int) data[i];        \
+            data[i] = (int) (expr);                         \
+        }                                                   \
+    }
+KERNEL_TABLE(MAP_SCALAR)
+
+#define SCALAR_ENTRY(name, fn, m, a, expr) map_##name##_scalar,
+static void (*const map_scalar[NUM_KERNELS])(int *, int) = {
+    KERNEL_TABLE(SCALAR_ENTRY)
+};
+
+#ifdef USE_SIMD
+typedef unsigned int v4u __attribute__((vector_size(16)));
+typedef unsigned int v8u __attribute__((vector_size(32)));
+
+#define MAP_VECTOR(name, fn, m, a, expr, isa, type, attr)   \
+    attr static void map_##name##_##isa(int *data, int n) { \
+        int i = 0;                                          \
+        for (; i + (int) (sizeof(type) / 4) <= n;           \
+             i += sizeof(type) / 4) {                       \
+            type u;                                         \
+            memcpy(&u, data + i, sizeof(u));                \
+            u = expr;                                       \
+            memcpy(data + i, &u, sizeof(u));                \
+        }                                                   \
+        map_##name##_scalar(data + i, n - i);               \
+    }
+#define MAP_SSE2(name, fn, m, a, expr) \
+    MAP_VECTOR(name, fn, m, a, expr, sse2, v4u, )
+#define MAP_AVX2(name, fn, m, a, expr) \
+    MAP_VECTOR(name, fn, m, a, expr, avx2, v8u, __attribute__((target("avx2"))))
+KERNEL_TABLE(MAP_SSE2)
+KERNEL_TABLE(MAP_AVX2)
+
+#define SSE2_ENTRY(name, fn, m, a, expr) map_##name##_sse2,
+#define AVX2_ENTRY(name, fn, m, a, expr) map_##name##_avx2,
+static void (*const map_sse2[NUM_KERNELS])(int *, int) = {
+    KERNEL_TABLE(SSE2_ENTRY)
+};
+static void (*const map_avx2[NUM_KERNELS])(int *, int) = {
+    KERNEL_TABLE(AVX2_ENTRY)
+};
+#endif
+
+static long (*sum_impl)(const int *, int) = NULL;
+static void (*const *map_impl)(int *, int) = NULL;
+static void (*affine_impl)(int *, int, unsigned int, unsigned int) = NULL;
+
+// Picks the widest implementation the CPU supports, once.
+static void pick_impl(void) {
+    sum_impl = sum_scalar;
+    map_impl = map_scalar;
+    affine_impl = affine_scalar;
+#ifdef USE_SIMD
+    sum_impl = sum_sse2;
+    map_impl = map_sse2;
+    affine_impl = affine_sse2;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        sum_impl = sum_avx2;
+        map_impl = map_avx2;
+        affine_impl = affine_avx2;
+    }
+#endif
+}
+
+// Picks the implementations up front, must be called before the kernels
+// are used from more than one thread.
+void init_kernels(void) {
+    if (!sum_impl) {
+        pick_impl();
+    }
+}
+
+// Returns the sum of data[0..n), widened to long.
+long sum_ints(const int *data, int n) {
+    if (!sum_impl) {
+        pick_impl();
+    }
+    return sum_impl(data, n);
+}
+
+// Applies the given kernel to data[0..n) in place.
+void map_ints(int *data, int n, int kernel) {
+    if (!map_impl) {
+        pick_impl();
+    }
+    map_impl[kernel](data, n);
+}
+
+// Replaces every x in data[0..n) with mul * x + add, wrapping on overflow.
+void map_affine_ints(int *data, int n, unsigned int mul, unsigned int add) {
+    if (!affine_impl) {
+        pick_impl();
+    }
+    affine_impl(data, n, mul, add);
+}
@@ -0,0 +1,34 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Vectorised loops over packed node data. The SSE2 or AVX2 versions are
+// picked at runtime from what the CPU supports, build with -DNO_SIMD to
+// force the scalar loops.
+
+// Every transform in functions.c that has a vectorised kernel, as
+// X(name, func, mul, add, expr). mul and add are its coefficients if it
+// is x -> mul * x + add, or 0 and 0 if it is not affine, and expr
+// computes it from u, the value as an unsigned int (or a vector of
+// them). The kernel ids, the lookups and the map loops are all
+// generated from this list, so adding a transform is one line here.
+#define KERNEL_TABLE(X)                             \
+    X(ADD_ONE, add_one, 1, 1, u + 1u)               \
+    X(ADD_TWO, add_two, 1, 2, u + 2u)               \
+    X(MULTIPLY_FIVE, multiply_five, 5, 0, u * 5u)   \
+    X(SQUARE, square, 0, 0, u * u)                  \
+    X(CUBE, cube, 0, 0, u * u * u)
+
+#define KERNEL_ID(name, func, mul, add, expr) KERNEL_##name,
+enum { KERNEL_TABLE(KERNEL_ID) NUM_KERNELS };
+#define KERNEL_NONE -1
+
+void init_kernels(void);
+int kernel_for(int (*func)(int));
+int kernel_affine(int kernel, int *mul, int *add);
+long sum_ints(const int *data, int n);
+void map_ints(int *data, int n, int kernel);
+void map_affine_ints(int *data, int n, unsigned int mul, unsigned int add);
@@ -0,0 +1,318 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Runs a trace that drives many independent lists at once. Every
+// instruction is the usual ex3 instruction prefixed by the id of the
+// list it applies to (any int), e.g. "42 1 0 7" inserts 7 at the front
+// of list 42. Binary traces (see trace_conv -t) put the id as a varint
+// before the opcode byte.
+//
+// Instructions are read in batches. The lists seen in a batch are spread
+// over worker threads by how many instructions they have. Each worker
+// runs its lists' instructions in input order, and the SUM_LIST results
+// are printed in input order once the batch is done. LIST_THREADS sets
+// the number of workers, as it does for the pool. tagged_test.in mixes
+// eight lists and must give tagged_test.out for any LIST_THREADS.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "function_pointers.h"
+#include "kernels.h"
+#include "node.h"
+#include "pool.h"
+#include "reader.h"
+#include "writer.h"
+
+// Macros
+#define SUM_LIST 0
+#define INSERT_AT 1
+#define DELETE_AT 2
+#define ROTATE_LIST 3
+#define REVERSE_LIST 4
+#define RESET_LIST 5
+#define MAP 6
+#define INSERT_MANY 7
+#define DELETE_RANGE 8
+
+#ifndef BATCH_INSTRS
+#define BATCH_INSTRS (1 << 20)
+#endif
+
+typedef struct {
+    int list;       // dense list number
+    int op;
+    int arg1;       // index, offset or function; output slot for SUM_LIST
+    int arg2;       // data or count
+    long values;    // INSERT_MANY: first value in batch_values
+} instr;
+
+// The batch being run
+static instr *batch;
+static int batch_len;
+static int *batch_values;
+static long num_values, values_cap;
+static long *outputs;
+static int num_outputs;
+
+// Every list seen so far, with ids mapped to dense numbers through an
+// open addressing table
+static list **lists;
+static int num_lists, lists_cap;
+static int *table_ids, *table_slots;
+static int table_cap;
+
+// Per batch: how many instructions each list has, where its run of
+// instruction numbers starts in order[], and which worker owns it
+static int *list_count, *list_start, *list_worker;
+static int *order;
+
+static int num_workers;
+
+static unsigned int hash_id(int id) {
+    return (unsigned int) id * 2654435761u;
+}
+
+static void table_put(int id, int slot) {
+    unsigned int i = hash_id(id) & (table_cap - 1);
+    while (table_slots[i] >= 0) {
+        i = (i + 1) & (table_cap - 1);
+    }
+    table_ids[i] = id;
+    table_slots[i] = slot;
+}
+
+static void table_grow(void) {
+    int old_cap = table_cap;
+    int *old_ids = table_ids, *old_slots = table_slots;
+    table_cap = old_cap ? 2 * old_cap : 1024;
+    table_ids = (int *) malloc(table_cap * sizeof(int));
+    table_slots = (int *) malloc(table_cap * sizeof(int));
+    for (int i = 0; i < table_cap; i++) {
+        table_slots[i] = -1;
+    }
+    for (int i = 0; i < old_cap; i++) {
+        if (old_slots[i] >= 0) {
+            table_put(old_ids[i], old_slots[i]);
+        }
+    }
+    free(old_ids);
+    free(old_slots);
+}
+
+// Returns the dense number of list id, creating the list on first use.
+static int list_for(int id) {
+    if (table_cap) {
+        unsigned int i = hash_id(id) & (table_cap - 1);
+        while (table_slots[i] >= 0) {
+            if (table_ids[i] == id) {
+                return table_slots[i];
+            }
+            i = (i + 1) & (table_cap - 1);
+        }
+    }
+    // keep the table at most half full
+    if (2 * (num_lists + 1) > table_cap) {
+        table_grow();
+    }
+    if (num_lists == lists_cap) {
+        lists_cap = lists_cap ? 2 * lists_cap : 1024;
+        lists = (list **) realloc(lists, lists_cap * sizeof(list *));
+        list_count = (int *) realloc(list_count, lists_cap * sizeof(int));
+        list_start = (int *) realloc(list_start, lists_cap * sizeof(int));
+        list_worker = (int *) realloc(list_worker, lists_cap * sizeof(int));
+    }
+    lists[num_lists] = (list *) malloc(sizeof(list));
+    init_list(lists[num_lists]);
+    table_put(id, num_lists);
+    return num_lists++;
+}
+
+// Reads up to BATCH_INSTRS instructions, returns 0 once there are none.
+static int read_batch(reader *in) {
+    batch_len = 0;
+    num_values = 0;
+    num_outputs = 0;
+    int id, op;
+    while (batch_len < BATCH_INSTRS && read_int(in, &id)
+           && read_op(in, &op)) {
+        instr *ins = &batch[batch_len++];
+        ins->list = list_for(id);
+        ins->op = op;
+        switch (op) {
+            case SUM_LIST:
+                ins->arg1 = num_outputs++;
+                break;
+            case INSERT_AT:
+                read_int(in, &ins->arg1);
+                read_int(in, &ins->arg2);
+                break;
+            case INSERT_MANY:
+                read_int(in, &ins->arg1);
+                read_int(in, &ins->arg2);
+                if (num_values + ins->arg2 > values_cap) {
+                    while (num_values + ins->arg2 > values_cap) {
+                        values_cap = values_cap ? 2 * values_cap : 1 << 16;
+                    }
+                    batch_values = (int *) realloc(batch_values,
+                                                   values_cap * sizeof(int));
+                }
+                ins->values = num_values;
+                for (int i = 0; i < ins->arg2; i++) {
+                    read_int(in, &batch_values[num_values++]);
+                }
+                break;
+            case DELETE_RANGE:
+                read_int(in, &ins->arg1);
+                read_int(in, &ins->arg2);
+                break;
+            case DELETE_AT:
+            case ROTATE_LIST:
+            case MAP:
+                read_int(in, &ins->arg1);
+        }
+    }
+    return batch_len > 0;
+}
+
+// Hands every list to the worker with the fewest instructions of the
+// batch so far, and groups the instruction numbers of every list
+// together in input order.
+static void shard_batch(void) {
+    for (int l = 0; l < num_lists; l++) {
+        list_count[l] = 0;
+    }
+    for (int i = 0; i < batch_len; i++) {
+        list_count[batch[i].list]++;
+    }
+    int pos = 0;
+    for (int l = 0; l < num_lists; l++) {
+        list_start[l] = pos;
+        pos += list_count[l];
+    }
+    for (int i = 0; i < batch_len; i++) {
+        order[list_start[batch[i].list]++] = i;
+    }
+    for (int l = 0; l < num_lists; l++) {
+        list_start[l] -= list_count[l];
+    }
+
+    long load[num_workers];
+    for (int w = 0; w < num_workers; w++) {
+        load[w] = 0;
+    }
+    for (int l = 0; l < num_lists; l++) {
+        int best = 0;
+        for (int w = 1; w < num_workers; w++) {
+            if (load[w] < load[best]) {
+                best = w;
+            }
+        }
+        list_worker[l] = best;
+        load[best] += list_count[l];
+    }
+}
+
+static void run(list *lst, const instr *ins) {
+    switch (ins->op) {
+        case SUM_LIST:
+            outputs[ins->arg1] = sum_list(lst);
+            break;
+        case INSERT_AT:
+            insert_node_at(lst, ins->arg1, ins->arg2);
+            break;
+        case DELETE_AT:
+            delete_node_at(lst, ins->arg1);
+            break;
+        case ROTATE_LIST:
+            rotate_list(lst, ins->arg1);
+            break;
+        case REVERSE_LIST:
+            reverse_list(lst);
+            break;
+        case RESET_LIST:
+            reset_list(lst);
+            break;
+        case MAP:
+            map(lst, func_list[ins->arg1]);
+            break;
+        case INSERT_MANY:
+            insert_many(lst, ins->arg1, batch_values + ins->values, ins->arg2);
+            break;
+        case DELETE_RANGE:
+            delete_range(lst, ins->arg1, ins->arg2);
+    }
+}
+
+static void *worker(void *arg) {
+    int w = (int) (long) arg;
+    for (int l = 0; l < num_lists; l++) {
+        if (list_worker[l] != w) {
+            continue;
+        }
+        for (int k = 0; k < list_count[l]; k++) {
+            run(lists[l], &batch[order[list_start[l] + k]]);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Error: expecting 1 argument, %d found\n", argc - 1);
+        exit(1);
+    }
+    update_functions();
+    reader in;
+    if (!reader_open(&in, argv[1])) {
+        printf("Error reading file %s\n.", argv[1]);
+        exit(1);
+    }
+    // the lists themselves are the unit of parallelism, so keep the
+    // pool out of the workers' way
+    num_workers = pool_threads();
+    set_pool_threads(1);
+    init_kernels();
+
+    batch = (instr *) malloc(BATCH_INSTRS * sizeof(instr));
+    outputs = (long *) malloc(BATCH_INSTRS * sizeof(long));
+    order = (int *) malloc(BATCH_INSTRS * sizeof(int));
+    while (read_batch(&in)) {
+        shard_batch();
+        pthread_t tids[num_workers];
+        for (int w = 1; w < num_workers; w++) {
+            pthread_create(&tids[w], NULL, worker, (void *) (long) w);
+        }
+        worker((void *) 0L);
+        for (int w = 1; w < num_workers; w++) {
+            pthread_join(tids[w], NULL);
+        }
+        for (int i = 0; i < num_outputs; i++) {
+            print_long(outputs[i]);
+            print_char('\n');
+        }
+    }
+    flush_output();
+
+    for (int l = 0; l < num_lists; l++) {
+        reset_list(lists[l]);
+        free(lists[l]);
+    }
+    free(lists);
+    free(list_count);
+    free(list_start);
+    free(list_worker);
+    free(table_ids);
+    free(table_slots);
+    free(batch);
+    free(batch_values);
+    free(outputs);
+    free(order);
+    reader_close(&in);
+}
@@ -8,150 +8,1240 @@
 #include "node.h"
 
 #include <ctype.h>
+#include <limits.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "kernels.h"
+#include "pool.h"
+
+#ifdef LIST_STATS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
 // Copy in your implementation of the functions from ex2.
 // There is one extra function called map which you have to fill up too.
 // Feel free to add any new functions as you deem fit.
-int get_len(node *cur_node) {
-    node *head = cur_node;
-    int len = 1;
-    while (cur_node->next != head) {
-        cur_node = cur_node->next;
-        len++;
+
+// Building with -DLIST_STATS counts, for every public op, how often it
+// was called, how many tree nodes it visited, how many nodes and slabs
+// it allocated and how long it took. dump_list_stats prints the totals.
+// The counters are global, so only count single-threaded runs.
+// Without it the STAT_ macros expand to nothing.
+#ifdef LIST_STATS
+enum {
+    STAT_INSERT, STAT_DELETE, STAT_INSERT_MANY, STAT_DELETE_RANGE,
+    STAT_ROTATE, STAT_REVERSE, STAT_RESET, STAT_MAP, STAT_SUM,
+    STAT_TRAVERSE, STAT_SNAPSHOT, STAT_RELEASE_VERSION, STAT_COPY_VERSION,
+    NUM_STATS
+};
+
+static const char *stat_names[NUM_STATS] = {
+    "insert_node_at", "delete_node_at", "insert_many", "delete_range",
+    "rotate_list", "reverse_list", "reset_list", "map", "sum_list",
+    "traverse_list", "snapshot", "release_version", "copy_version"
+};
+
+typedef struct {
+    long calls;
+    long nodes;         // tree nodes visited
+    long allocs;        // nodes handed out
+    long slabs;         // slabs malloc'd
+    unsigned long ticks;
+} op_stats;
+
+static op_stats stats[NUM_STATS];
+static int stat_depth = 0;  // public ops nest, e.g. map calls map_affine
+static int stat_op = 0;     // outermost op running
+static unsigned long stat_start;
+
+// Cycles where there is a TSC, nanoseconds elsewhere
+static unsigned long stat_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+#endif
+}
+
+static int stat_enter(int op) {
+    if (!stat_depth++) {
+        stat_op = op;
+        stats[op].calls++;
+        stat_start = stat_clock();
+    }
+    return 0;
+}
+
+static void stat_leave(int *guard) {
+    (void) guard;
+    if (!--stat_depth) {
+        stats[stat_op].ticks += stat_clock() - stat_start;
+    }
+}
+
+// Times the rest of the enclosing function, however it returns.
+#define STAT_OP(op) \
+    int stat_guard __attribute__((cleanup(stat_leave), unused)) \
+        = stat_enter(STAT_##op)
+#define STAT_COUNT(field) (stats[stat_op].field++)
+#else
+#define STAT_OP(op)
+#define STAT_COUNT(field) ((void) 0)
+#endif
+
+// Prints the counters collected under -DLIST_STATS to stderr.
+void dump_list_stats(void) {
+#ifdef LIST_STATS
+#if defined(__x86_64__) || defined(__i386__)
+    const char *unit = "cycles";
+#else
+    const char *unit = "ns";
+#endif
+    fprintf(stderr, "%-15s %10s %12s %10s %6s %12s/call\n", "op", "calls",
+            "nodes", "allocs", "slabs", unit);
+    for (int i = 0; i < NUM_STATS; i++) {
+        if (stats[i].calls) {
+            fprintf(stderr, "%-15s %10ld %12ld %10ld %6ld %17.1f\n",
+                    stat_names[i], stats[i].calls, stats[i].nodes,
+                    stats[i].allocs, stats[i].slabs,
+                    (double) stats[i].ticks / stats[i].calls);
+        }
+    }
+#endif
+}
+
+// xorshift32, only used to pick treap priorities. The state lives in the
+// list so separate lists can be driven from separate threads.
+static unsigned int next_prio(list *lst) {
+    lst->prio_state ^= lst->prio_state << 13;
+    lst->prio_state ^= lst->prio_state >> 17;
+    lst->prio_state ^= lst->prio_state << 5;
+    return lst->prio_state;
+}
+
+static int get_size(node *n) {
+    return n ? n->size : 0;
+}
+
+// Recomputes the aggregates of n->data, which must have no pending tag.
+static void refresh_data(node *n) {
+    n->data_sum = sum_ints(n->data, n->cnt);
+    n->data_min = INT_MAX;
+    n->data_max = INT_MIN;
+    for (int i = 0; i < n->cnt; i++) {
+        if (n->data[i] < n->data_min) {
+            n->data_min = n->data[i];
+        }
+        if (n->data[i] > n->data_max) {
+            n->data_max = n->data[i];
+        }
+    }
+}
+
+static void add_child(node *n, node *child) {
+    if (!child) {
+        return;
+    }
+    n->size += child->size;
+    n->sum += child->sum;
+    if (child->min < n->min) {
+        n->min = child->min;
+    }
+    if (child->max > n->max) {
+        n->max = child->max;
     }
-    return len;
 }
 
-node *get_node(node *node, int index) {
-    while (index) {
-        node = node->next;
-        index--;
+static void update(node *n) {
+    n->size = n->cnt;
+    n->sum = n->data_sum;
+    n->min = n->data_min;
+    n->max = n->data_max;
+    add_child(n, n->left);
+    add_child(n, n->right);
+}
+
+// Returns 1 if x -> mul * x + add maps every value of n without
+// overflowing an int. The map is monotonic, increasing or decreasing,
+// so only the extremes matter.
+static int fits(node *n, int mul, int add) {
+    long lo = 1L * mul * n->min + add;
+    long hi = 1L * mul * n->max + add;
+    return lo >= INT_MIN && lo <= INT_MAX && hi >= INT_MIN && hi <= INT_MAX;
+}
+
+// Applies x -> mul * x + add to the whole subtree of n in O(1): the
+// aggregates are updated in closed form and the rest is left pending.
+// Unsigned arithmetic makes composed tags wrap exactly like the values.
+// A negative mul turns the smallest value into the largest. Tags are
+// only applied where no value overflows, so the sign of mul is exact
+// whenever min and max differ.
+static void apply_tag(node *n, unsigned long mul, unsigned long add) {
+    int flip = (long) mul < 0;
+    int min = (int) (mul * (unsigned long) n->min + add);
+    int max = (int) (mul * (unsigned long) n->max + add);
+    int data_min = (int) (mul * (unsigned long) n->data_min + add);
+    int data_max = (int) (mul * (unsigned long) n->data_max + add);
+    n->sum = (long) (mul * (unsigned long) n->sum + add * n->size);
+    n->min = flip ? max : min;
+    n->max = flip ? min : max;
+    n->data_sum = (long) (mul * (unsigned long) n->data_sum + add * n->cnt);
+    n->data_min = flip ? data_max : data_min;
+    n->data_max = flip ? data_min : data_max;
+    n->add = mul * n->add + add;
+    n->mul = mul * n->mul;
+}
+
+// Sets up an empty list, must be called before any other list function.
+void init_list(list *lst) {
+    lst->root = NULL;
+    lst->head_pos = 0;
+    lst->reversed = 0;
+    lst->dirty = 0;
+    lst->mem = NULL;
+    lst->segs = NULL;
+    lst->num_segs = -1;
+    lst->segs_cap = 0;
+    lst->finger = NULL;
+    lst->finger_depth = 0;
+    lst->finger_delta = 0;
+    lst->finger_stale = 0;
+    lst->prio_state = 2463534242u;
+}
+
+static node *alloc_node(list *lst) {
+    STAT_COUNT(allocs);
+    arena *mem = lst->mem;
+    if (!mem) {
+        mem = lst->mem = (arena *) malloc(sizeof(arena));
+        mem->refs = 1;
+        mem->slabs = NULL;
+        mem->slab_used = SLAB_NODES;
+        mem->free_nodes = NULL;
     }
-    return node;
+    node *n = mem->free_nodes;
+    if (n) {
+        mem->free_nodes = n->right;
+        return n;
+    }
+    if (mem->slab_used == SLAB_NODES) {
+        STAT_COUNT(slabs);
+        slab *s = (slab *) malloc(sizeof(slab));
+        s->next = mem->slabs;
+        mem->slabs = s;
+        mem->slab_used = 0;
+    }
+    return &mem->slabs->nodes[mem->slab_used++];
+}
+
+static void free_node(arena *mem, node *n) {
+    n->right = mem->free_nodes;
+    mem->free_nodes = n;
+}
+
+// Drops one reference to mem, freeing every slab with the last one.
+static void release_arena(arena *mem) {
+    if (!mem || --mem->refs) {
+        return;
+    }
+    // nodes live in the slabs, so there is no need to visit them
+    slab *s = mem->slabs;
+    while (s) {
+        slab *tmp = s->next;
+        free(s);
+        s = tmp;
+    }
+    free(mem);
+}
+
+// Returns an empty node with no children.
+static node *new_node(list *lst, unsigned int prio) {
+    node *n = alloc_node(lst);
+    n->cnt = 0;
+    n->refs = 1;
+    n->size = 0;
+    n->prio = prio;
+    n->data_sum = 0L;
+    n->data_min = INT_MAX;
+    n->data_max = INT_MIN;
+    n->mul = 1;
+    n->add = 0;
+    n->left = n->right = NULL;
+    update(n);
+    return n;
+}
+
+// Returns t if nothing else points at it, otherwise a copy of t that
+// takes over the caller's reference. A mutation has to pass every node
+// it changes through here, from the root down, so that what it changes
+// is only reachable through the list.
+static node *own(list *lst, node *t) {
+    if (t->refs == 1) {
+        return t;
+    }
+    node *c = alloc_node(lst);
+    memcpy(c, t, offsetof(node, data) + t->cnt * sizeof(int));
+    c->refs = 1;
+    if (c->left) {
+        c->left->refs++;
+    }
+    if (c->right) {
+        c->right->refs++;
+    }
+    t->refs--;
+    return c;
+}
+
+// Applies the pending tag of n to its data and hands it to its children.
+// n must be owned by lst.
+static void push_down(list *lst, node *n) {
+    if (n->mul == 1 && n->add == 0) {
+        return;
+    }
+    map_affine_ints(n->data, n->cnt, (unsigned int) n->mul,
+                    (unsigned int) n->add);
+    if (n->left) {
+        n->left = own(lst, n->left);
+        apply_tag(n->left, n->mul, n->add);
+    }
+    if (n->right) {
+        n->right = own(lst, n->right);
+        apply_tag(n->right, n->mul, n->add);
+    }
+    n->mul = 1;
+    n->add = 0;
+}
+
+// Concatenates a and b, every node of a ends up before every node of b.
+static node *merge(list *lst, node *a, node *b) {
+    if (!a || !b) {
+        return a ? a : b;
+    }
+    STAT_COUNT(nodes);
+    if (a->prio > b->prio) {
+        a = own(lst, a);
+        push_down(lst, a);
+        a->right = merge(lst, a->right, b);
+        update(a);
+        return a;
+    }
+    b = own(lst, b);
+    push_down(lst, b);
+    b->left = merge(lst, a, b->left);
+    update(b);
+    return b;
+}
+
+// t and the child that moves up must be owned.
+static node *rotate_left(node *t) {
+    node *r = t->right;
+    t->right = r->left;
+    update(t);
+    r->left = t;
+    update(r);
+    return r;
+}
+
+static node *rotate_right(node *t) {
+    node *l = t->left;
+    t->left = l->right;
+    update(t);
+    l->right = t;
+    update(l);
+    return l;
+}
+
+static node *insert_rec(list *lst, node *t, int index, int data) {
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    int left_size = get_size(t->left);
+    if (index < left_size) {
+        t->left = insert_rec(lst, t->left, index, data);
+        update(t);
+        return t->left->prio > t->prio ? rotate_right(t) : t;
+    }
+    if (index > left_size + t->cnt) {
+        t->right = insert_rec(lst, t->right, index - left_size - t->cnt, data);
+        update(t);
+        return t->right->prio > t->prio ? rotate_left(t) : t;
+    }
+    int pos = index - left_size;
+    node *target = t;
+    node *tail = NULL;
+    if (t->cnt == NODE_CAP) {
+        // full, so move the upper half into a new successor node. An
+        // insert at either end of the node leaves the old values together
+        // instead, so appends and prepends pack nodes full rather than
+        // leaving a trail of half empty ones.
+        int half = pos <= NODE_CAP / 2 ? NODE_CAP / 2 : (NODE_CAP + 1) / 2;
+        if (pos == 0 || pos == NODE_CAP) {
+            half = pos;
+        }
+        tail = new_node(lst, next_prio(lst));
+        tail->cnt = NODE_CAP - half;
+        memcpy(tail->data, t->data + half, tail->cnt * sizeof(int));
+        t->cnt = half;
+        if (pos > half || half == NODE_CAP) {
+            target = tail;
+            pos -= half;
+        }
+    }
+    memmove(target->data + pos + 1, target->data + pos,
+            (target->cnt - pos) * sizeof(int));
+    target->data[pos] = data;
+    target->cnt++;
+    refresh_data(t);
+    if (tail) {
+        // the tail is a new node with a random priority, inserted as t's
+        // successor like any treap insert: merge puts it at the top of
+        // t->right only if it outranks everything there, and then its
+        // left child is empty so one rotation lifts it above t. Callers
+        // keep rotating it up while it outranks their node.
+        refresh_data(tail);
+        update(tail);
+        t->right = merge(lst, tail, t->right);
+    }
+    update(t);
+    if (t->right && t->right->prio > t->prio) {
+        return rotate_left(t);
+    }
+    return t;
+}
+
+// Number of values in lst, counting edits still pending on the finger.
+static int list_len(list *lst) {
+    return lst->root ? lst->root->size + lst->finger_delta : 0;
+}
+
+// Applies the deferred updates to every ancestor of the finger.
+static void sync_finger(list *lst) {
+    if (!lst->finger_stale) {
+        return;
+    }
+    for (int i = lst->finger_depth - 1; i >= 0; i--) {
+        update(lst->finger_path[i]);
+    }
+    lst->finger_delta = 0;
+    lst->finger_stale = 0;
+}
+
+// Must be called before anything reshapes the tree or tags a subtree.
+static void drop_finger(list *lst) {
+    sync_finger(lst);
+    lst->finger = NULL;
+}
+
+// Points the finger at the node holding physical position pos, or at the
+// node insert_rec would put a value at pos into if inserting is set.
+// Leaves it NULL if the path is too deep to record.
+static void seek_finger(list *lst, int pos, int inserting) {
+    drop_finger(lst);
+    // the finger edits its path in place, so take it over on the way
+    node **link = &lst->root;
+    int start = 0;
+    int depth = 0;
+    while (*link && depth < FINGER_DEPTH) {
+        STAT_COUNT(nodes);
+        node *t = *link = own(lst, *link);
+        push_down(lst, t);
+        lst->finger_path[depth++] = t;
+        int left_size = get_size(t->left);
+        int end = start + left_size + t->cnt;
+        if (pos < start + left_size) {
+            link = &t->left;
+        } else if (pos > end || (pos == end && !inserting)) {
+            start = end;
+            link = &t->right;
+        } else {
+            lst->finger = t;
+            lst->finger_start = start + left_size;
+            lst->finger_depth = depth;
+            return;
+        }
+    }
+}
+
+// Inserts data at physical position pos in place if the finger node can
+// take it, returns 0 if the tree has to be reshaped instead.
+static int finger_insert(list *lst, int pos, int data) {
+    node *f = lst->finger;
+    if (!f || pos < lst->finger_start || pos > lst->finger_start + f->cnt) {
+        seek_finger(lst, pos, 1);
+        f = lst->finger;
+    }
+    if (!f || f->cnt == NODE_CAP) {
+        return 0;
+    }
+    int i = pos - lst->finger_start;
+    memmove(f->data + i + 1, f->data + i, (f->cnt - i) * sizeof(int));
+    f->data[i] = data;
+    f->cnt++;
+    f->data_sum += data;
+    if (data < f->data_min) {
+        f->data_min = data;
+    }
+    if (data > f->data_max) {
+        f->data_max = data;
+    }
+    lst->finger_delta++;
+    lst->finger_stale = 1;
+    return 1;
+}
+
+// Returns the physical position a value inserted at logical index of a
+// list of len values goes to.
+static int insert_pos(list *lst, int index, int len) {
+    if (lst->reversed) {
+        // logical index runs backwards, so go just after its occupant
+        return ((lst->head_pos - index) % len + len) % len + 1;
+    }
+    // goes just before the current occupant of logical index. Appending
+    // to a list whose head is at 0 goes to the physical end rather than
+    // the front, so the values stay in physical order.
+    int pos = lst->head_pos + index;
+    return pos > len ? pos - len : pos;
 }
 
 // Inserts a new node with data value at index (counting from head
 // starting at 0).
 // Note: index is guaranteed to be valid.
 void insert_node_at(list *lst, int index, int data) {
-    node *new_node = (node *) malloc(sizeof(node));
-    new_node->data = data;
-    if (!lst->head) {
-        lst->head = new_node;
-        lst->head->next = new_node;
-        return;
-    }
-    int len = get_len(lst->head); // ideally this shd be in the struct.
-    int prev_node_idx = ((index - 1) + len) % len;
-    int next_node_idx = index % len;
-    node *prev_node = get_node(lst->head, prev_node_idx);
-    node *next_node = get_node(lst->head, next_node_idx);
-    prev_node->next = new_node;
-    new_node->next = next_node;
-    // if new_node is first index, update head
+    STAT_OP(INSERT);
+    if (!lst->root) {
+        lst->root = new_node(lst, next_prio(lst));
+        lst->head_pos = 0;
+        lst->reversed = 0;
+        lst->root = insert_rec(lst, lst->root, 0, data);
+        lst->num_segs = -1;
+        return;
+    }
+    int len = list_len(lst);
+    int pos = insert_pos(lst, index, len);
+    if (!finger_insert(lst, pos, data)) {
+        // full node, splitting it reshapes the tree
+        drop_finger(lst);
+        lst->root = insert_rec(lst, lst->root, pos, data);
+        lst->num_segs = -1;
+    }
     if (!index) {
-        lst->head = new_node;
+        lst->head_pos = pos;
+    } else if (pos <= lst->head_pos) {
+        lst->head_pos++;
+    }
+}
+
+// Unlinks the first node of t, appending its values to dst.
+static node *pop_front(list *lst, node *t, node *dst) {
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    if (t->left) {
+        t->left = pop_front(lst, t->left, dst);
+        update(t);
+        return t;
+    }
+    memcpy(dst->data + dst->cnt, t->data, t->cnt * sizeof(int));
+    dst->cnt += t->cnt;
+    node *rest = t->right;
+    free_node(lst->mem, t);
+    return rest;
+}
+
+// Unlinks the last node of t, prepending its values to dst.
+static node *pop_back(list *lst, node *t, node *dst) {
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    if (t->right) {
+        t->right = pop_back(lst, t->right, dst);
+        update(t);
+        return t;
+    }
+    memmove(dst->data + t->cnt, dst->data, dst->cnt * sizeof(int));
+    memcpy(dst->data, t->data, t->cnt * sizeof(int));
+    dst->cnt += t->cnt;
+    node *rest = t->left;
+    free_node(lst->mem, t);
+    return rest;
+}
+
+static node *first_node(node *t) {
+    while (t->left) {
+        t = t->left;
+    }
+    return t;
+}
+
+static node *last_node(node *t) {
+    while (t->right) {
+        t = t->right;
+    }
+    return t;
+}
+
+static node *delete_rec(list *lst, node *t, int index) {
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    int left_size = get_size(t->left);
+    if (index < left_size) {
+        t->left = delete_rec(lst, t->left, index);
+    } else if (index >= left_size + t->cnt) {
+        t->right = delete_rec(lst, t->right, index - left_size - t->cnt);
+    } else {
+        int pos = index - left_size;
+        memmove(t->data + pos, t->data + pos + 1,
+                (t->cnt - pos - 1) * sizeof(int));
+        t->cnt--;
+        if (!t->cnt) {
+            node *rest = merge(lst, t->left, t->right);
+            free_node(lst->mem, t);
+            return rest;
+        }
+        // absorb a sparse neighbour so nodes stay reasonably full
+        if (t->cnt <= NODE_CAP / 4) {
+            if (t->right && t->cnt + first_node(t->right)->cnt <= NODE_CAP) {
+                t->right = pop_front(lst, t->right, t);
+            } else if (t->left
+                       && t->cnt + last_node(t->left)->cnt <= NODE_CAP) {
+                t->left = pop_back(lst, t->left, t);
+            }
+        }
+        refresh_data(t);
+    }
+    update(t);
+    return t;
+}
+
+// Deletes the value at physical position pos in place if that leaves
+// the finger node well filled, returns 0 if the tree has to be reshaped
+// instead.
+static int finger_delete(list *lst, int pos) {
+    node *f = lst->finger;
+    if (!f || pos < lst->finger_start || pos >= lst->finger_start + f->cnt) {
+        seek_finger(lst, pos, 0);
+        f = lst->finger;
+    }
+    if (!f || f->cnt - 1 <= NODE_CAP / 4) {
+        return 0;
     }
+    int i = pos - lst->finger_start;
+    int data = f->data[i];
+    memmove(f->data + i, f->data + i + 1, (f->cnt - i - 1) * sizeof(int));
+    f->cnt--;
+    f->data_sum -= data;
+    if (data == f->data_min || data == f->data_max) {
+        refresh_data(f);
+    }
+    lst->finger_delta--;
+    lst->finger_stale = 1;
+    return 1;
 }
 
 // Deletes node at index (counting from head starting from 0).
 // Note: index is guarenteed to be valid.
 void delete_node_at(list *lst, int index) {
-    if (!lst->head) {
-        return;
-    }
-    int len = get_len(lst->head); // ideally this shd be in the struct.
-    int prev_node_idx = ((index - 1) + len) % len;
-    int next_node_idx = (index + 1) % len;
-    node *prev_node = get_node(lst->head, prev_node_idx);
-    node *next_node = get_node(lst->head, next_node_idx);
-    node *del_node = prev_node->next;
-    prev_node->next = next_node;
-    // if index is 0, we need to update the head
-    // set head to NULL if its the only node, or to
-    // next_node if len is > 1
+    STAT_OP(DELETE);
+    if (!lst->root) {
+        return;
+    }
+    int len = list_len(lst);
+    int pos = lst->reversed ? ((lst->head_pos - index) % len + len) % len
+                            : (lst->head_pos + index) % len;
+    if (!finger_delete(lst, pos)) {
+        // emptying or thinning out a node reshapes the tree
+        drop_finger(lst);
+        lst->root = delete_rec(lst, lst->root, pos);
+        lst->num_segs = -1;
+    }
+    if (len == 1) {
+        lst->head_pos = 0;
+    } else if (pos < lst->head_pos) {
+        lst->head_pos--;
+    } else if (pos == lst->head_pos) {
+        // the head moves on to the next value in logical order
+        lst->head_pos = lst->reversed ? (pos + len - 2) % (len - 1)
+                                      : pos % (len - 1);
+    }
+}
+
+// Splits t so that *a gets the first k values and *b the rest. A node
+// that straddles the cut has its upper values moved into a new node.
+static void split(list *lst, node *t, int k, node **a, node **b) {
+    if (!t) {
+        *a = *b = NULL;
+        return;
+    }
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    int left_size = get_size(t->left);
+    if (k <= left_size) {
+        split(lst, t->left, k, a, &t->left);
+        update(t);
+        *b = t;
+        return;
+    }
+    if (k >= left_size + t->cnt) {
+        split(lst, t->right, k - left_size - t->cnt, &t->right, b);
+        update(t);
+        *a = t;
+        return;
+    }
+    // the new node takes over t's place above t->right, so it can share
+    // t's priority
+    int pos = k - left_size;
+    node *rest = new_node(lst, t->prio);
+    rest->cnt = t->cnt - pos;
+    memcpy(rest->data, t->data + pos, rest->cnt * sizeof(int));
+    t->cnt = pos;
+    refresh_data(t);
+    refresh_data(rest);
+    rest->right = t->right;
+    t->right = NULL;
+    update(rest);
+    update(t);
+    *a = t;
+    *b = rest;
+}
+
+// Moves the first node of *b into the last node of t if they fit in one
+// node, so repeated splits do not leave a trail of tiny nodes.
+static node *absorb_front(list *lst, node *t, node **b) {
+    STAT_COUNT(nodes);
+    t = own(lst, t);
+    push_down(lst, t);
+    if (t->right) {
+        t->right = absorb_front(lst, t->right, b);
+    } else if (t->cnt + first_node(*b)->cnt <= NODE_CAP) {
+        *b = pop_front(lst, *b, t);
+        refresh_data(t);
+    }
+    update(t);
+    return t;
+}
+
+// Like merge, but also packs the two nodes that meet at the seam.
+static node *join(list *lst, node *a, node *b) {
+    if (a && b) {
+        a = absorb_front(lst, a, &b);
+    }
+    return merge(lst, a, b);
+}
+
+// Builds a treap holding values[0..n) in order, or in reverse order if
+// backward is set, from full nodes. Nodes are pushed through a stack of
+// the right spine (a Cartesian tree build) so this takes linear time.
+static node *build_tree(list *lst, const int *values, int n, int backward) {
+    int num_nodes = (n + NODE_CAP - 1) / NODE_CAP;
+    node **spine = (node **) malloc(num_nodes * sizeof(node *));
+    int depth = 0;
+    for (int k = 0; k < num_nodes; k++) {
+        node *cur = new_node(lst, next_prio(lst));
+        int lo = k * NODE_CAP;
+        cur->cnt = n - lo < NODE_CAP ? n - lo : NODE_CAP;
+        if (!backward) {
+            memcpy(cur->data, values + lo, cur->cnt * sizeof(int));
+        } else {
+            for (int i = 0; i < cur->cnt; i++) {
+                cur->data[i] = values[n - 1 - lo - i];
+            }
+        }
+        refresh_data(cur);
+        // everything popped off the spine is complete and hangs to the
+        // left of cur
+        node *popped = NULL;
+        while (depth && spine[depth - 1]->prio < cur->prio) {
+            popped = spine[--depth];
+            update(popped);
+        }
+        cur->left = popped;
+        if (depth) {
+            spine[depth - 1]->right = cur;
+        }
+        spine[depth++] = cur;
+    }
+    while (depth > 1) {
+        update(spine[--depth]);
+    }
+    node *root = spine[0];
+    update(root);
+    free(spine);
+    return root;
+}
+
+// Drops one reference to t, freeing whatever nothing else points at.
+static void free_tree(arena *mem, node *t) {
+    if (!t || --t->refs) {
+        return;
+    }
+    STAT_COUNT(nodes);
+    free_tree(mem, t->left);
+    free_tree(mem, t->right);
+    free_node(mem, t);
+}
+
+// Inserts values[0..n) so that values[0] ends up at index (counting from
+// head starting at 0) and the rest follow it in order.
+// Note: index is guaranteed to be valid.
+void insert_many(list *lst, int index, const int *values, int n) {
+    STAT_OP(INSERT_MANY);
+    if (n <= 0) {
+        return;
+    }
+    drop_finger(lst);
+    lst->num_segs = -1;
+    if (!lst->root) {
+        lst->root = build_tree(lst, values, n, 0);
+        lst->head_pos = 0;
+        lst->reversed = 0;
+        return;
+    }
+    // same position as insert_node_at would pick for values[0]; in a
+    // reversed list the values are laid out backwards from there
+    int len = lst->root->size;
+    int pos = insert_pos(lst, index, len);
+    node *chain = build_tree(lst, values, n, lst->reversed);
+    node *a, *b;
+    split(lst, lst->root, pos, &a, &b);
+    lst->root = join(lst, join(lst, a, chain), b);
     if (!index) {
-        lst->head = (len == 1) ? NULL : next_node;
+        lst->head_pos = lst->reversed ? pos + n - 1 : pos;
+    } else if (pos <= lst->head_pos) {
+        lst->head_pos += n;
+    }
+}
+
+// Deletes the n values starting at index (counting from head starting
+// from 0).
+// Note: the range is guaranteed to be valid.
+void delete_range(list *lst, int index, int n) {
+    STAT_OP(DELETE_RANGE);
+    if (!lst->root || n <= 0) {
+        return;
+    }
+    drop_finger(lst);
+    lst->num_segs = -1;
+    int len = lst->root->size;
+    if (n >= len) {
+        free_tree(lst->mem, lst->root);
+        lst->root = NULL;
+        lst->head_pos = 0;
+        return;
+    }
+    // the range covers the physical positions [start, start + n), which
+    // may wrap around the end
+    int start = lst->reversed
+                ? ((lst->head_pos - index - n + 1) % len + len) % len
+                : (lst->head_pos + index) % len;
+    // the new head is the old head, or the first value after the range
+    // if the range started at the head
+    int keep = index ? 0 : n;
+    int head = lst->reversed ? ((lst->head_pos - keep) % len + len) % len
+                             : (lst->head_pos + keep) % len;
+    node *a, *mid, *b;
+    if (start + n <= len) {
+        split(lst, lst->root, start, &a, &b);
+        split(lst, b, n, &mid, &b);
+        free_tree(lst->mem, mid);
+        lst->root = join(lst, a, b);
+        lst->head_pos = head < start ? head : head - n;
+    } else {
+        int end = start + n - len;
+        split(lst, lst->root, end, &mid, &b);
+        free_tree(lst->mem, mid);
+        split(lst, b, start - end, &a, &mid);
+        free_tree(lst->mem, mid);
+        lst->root = a;
+        lst->head_pos = head - end;
     }
-    free(del_node);
 }
 
 // Rotates list by the given offset.
 // Note: offset is guarenteed to be non-negative.
 void rotate_list(list *lst, int offset) {
-    if (!lst->head) {
+    STAT_OP(ROTATE);
+    if (!lst->root) {
         return;
     }
-    node *new_head = lst->head;
-    while (offset) {
-        new_head = new_head->next;
-        offset--;
+    // rotating by len is a no-op so only the remainder matters
+    int len = list_len(lst);
+    offset %= len;
+    if (lst->reversed) {
+        offset = len - offset;
     }
-    lst->head = new_head;
+    lst->head_pos = (lst->head_pos + offset) % len;
 }
 
 // Reverses the list, with the original "tail" node
 // becoming the new head node.
 void reverse_list(list *lst) {
-    if (!lst->head) {
+    STAT_OP(REVERSE);
+    if (!lst->root) {
         return;
     }
-    node *prev_node = lst->head;
-    node *next_node = prev_node->next;
-    while (next_node != lst->head) {
-        node *tmp = next_node->next;
-        next_node->next = prev_node;
-        prev_node = next_node;
-        next_node = tmp;
-    }
-    next_node->next = prev_node;
-    lst->head = prev_node;
+    // the old tail is the value just behind the head in the old direction
+    int len = list_len(lst);
+    lst->head_pos = (lst->head_pos + (lst->reversed ? 1 : len - 1)) % len;
+    lst->reversed = !lst->reversed;
 }
 
 // Resets list to an empty state (no nodes) and frees
 // any allocated memory in the process
 void reset_list(list *lst) {
-    if (!lst->head) {
-        return;
+    STAT_OP(RESET);
+    release_arena(lst->mem);
+    free(lst->segs);
+    init_list(lst);
+}
+
+// Pushes every pending tag down and appends the nodes of n to lst->segs
+// in order. The passes write to every node, so they are all taken over.
+static node *collect_nodes(list *lst, node *n) {
+    if (!n) {
+        return NULL;
+    }
+    STAT_COUNT(nodes);
+    n = own(lst, n);
+    push_down(lst, n);
+    n->left = collect_nodes(lst, n->left);
+    if (lst->num_segs == lst->segs_cap) {
+        lst->segs_cap = lst->segs_cap ? 2 * lst->segs_cap : SLAB_NODES;
+        lst->segs = (node **) realloc(lst->segs,
+                                      lst->segs_cap * sizeof(node *));
+    }
+    lst->segs[lst->num_segs++] = n;
+    n->right = collect_nodes(lst, n->right);
+    return n;
+}
+
+// Returns 1 if a pass over every value of lst is worth splitting across
+// threads, making sure lst->segs is current first.
+static int split_pass(list *lst) {
+    if (!lst->root || lst->root->size < PARALLEL_MIN || pool_threads() < 2) {
+        return 0;
     }
-    node *cur_node = lst->head->next;
-    while (cur_node != lst->head) {
-        node *tmp = cur_node->next;
-        free(cur_node);
-        cur_node = tmp;
+    if (lst->num_segs < 0) {
+        lst->num_segs = 0;
+        lst->root = collect_nodes(lst, lst->root);
     }
-    free(lst->head);
-    lst->head = NULL;
+    // the kernels pick their implementation lazily, which is not safe
+    // to race on
+    init_kernels();
+    return 1;
+}
+
+// Runs every step over the data of n, which must have no pending tag.
+static void map_data(node *n, const map_step *steps, const int *kernels,
+                     int num_steps) {
+    for (int s = 0; s < num_steps; s++) {
+        if (!steps[s].func) {
+            map_affine_ints(n->data, n->cnt, steps[s].mul, steps[s].add);
+        } else if (kernels[s] != KERNEL_NONE) {
+            map_ints(n->data, n->cnt, kernels[s]);
+        } else {
+            for (int i = 0; i < n->cnt; i++) {
+                n->data[i] = (*steps[s].func)(n->data[i]);
+            }
+        }
+    }
+}
+
+// Runs every step over a node's data before moving on, so a fused map
+// walks the tree once however many steps it has.
+static node *map_tree(list *lst, node *n, const map_step *steps,
+                      const int *kernels, int num_steps) {
+    if (!n) {
+        return NULL;
+    }
+    STAT_COUNT(nodes);
+    n = own(lst, n);
+    push_down(lst, n);
+    n->left = map_tree(lst, n->left, steps, kernels, num_steps);
+    map_data(n, steps, kernels, num_steps);
+    n->right = map_tree(lst, n->right, steps, kernels, num_steps);
+    return n;
+}
+
+typedef struct {
+    node **segs;
+    const map_step *steps;
+    const int *kernels;
+    int num_steps;
+} map_job;
+
+static void map_segs(void *arg, int lo, int hi) {
+    map_job *job = (map_job *) arg;
+    for (int i = lo; i < hi; i++) {
+        map_data(job->segs[i], job->steps, job->kernels, job->num_steps);
+    }
+}
+
+// Applies x -> mul * x + add, tagging every subtree that cannot
+// overflow and only visiting values in the ones that can.
+static node *map_affine_tree(list *lst, node *n, int mul, int add) {
+    if (!n) {
+        return NULL;
+    }
+    STAT_COUNT(nodes);
+    n = own(lst, n);
+    if (fits(n, mul, add)) {
+        apply_tag(n, mul, add);
+        return n;
+    }
+    push_down(lst, n);
+    map_affine_ints(n->data, n->cnt, mul, add);
+    refresh_data(n);
+    n->left = map_affine_tree(lst, n->left, mul, add);
+    n->right = map_affine_tree(lst, n->right, mul, add);
+    update(n);
+    return n;
 }
 
 // Traverses list and applies func on data values of
 // all elements in the list.
 void map(list *lst, int (*func)(int)) {
-    if (!lst->head) {
+    STAT_OP(MAP);
+    int mul, add;
+    if (kernel_affine(kernel_for(func), &mul, &add)) {
+        map_affine(lst, mul, add);
         return;
     }
-    node *head = lst->head;
-    do {
-        head->data = (*func)(head->data);
-        head = head->next;
-    } while (head != lst->head);
+    map_step step = { func, 1, 0 };
+    map_steps(lst, &step, 1);
+}
+
+// Replaces every value x with mul * x + add (wrapping like int
+// arithmetic would).
+void map_affine(list *lst, int mul, int add) {
+    STAT_OP(MAP);
+    if (!lst->dirty) {
+        // tagging the finger's ancestors would leave its data stale
+        drop_finger(lst);
+        lst->root = map_affine_tree(lst, lst->root, mul, add);
+        // the index only holds nodes without pending tags
+        lst->num_segs = -1;
+        return;
+    }
+    map_step step = { NULL, mul, add };
+    map_steps(lst, &step, 1);
+}
+
+// Applies steps[0], then steps[1], ... to every value in one pass. On
+// large lists the pass is split across threads, so any func must be
+// safe to call concurrently.
+void map_steps(list *lst, const map_step *steps, int num_steps) {
+    STAT_OP(MAP);
+    // the functions.c transforms have vectorised kernels, anything
+    // else goes through the function pointer
+    int kernels[num_steps];
+    for (int s = 0; s < num_steps; s++) {
+        kernels[s] = steps[s].func ? kernel_for(steps[s].func) : KERNEL_NONE;
+    }
+    sync_finger(lst);
+    if (split_pass(lst)) {
+        map_job job = { lst->segs, steps, kernels, num_steps };
+        pool_run(map_segs, &job, lst->num_segs);
+    } else {
+        lst->root = map_tree(lst, lst->root, steps, kernels, num_steps);
+    }
+    // the aggregates are only rebuilt once something asks for them
+    lst->dirty = 1;
+}
+
+// A dirty list shares no nodes (map_steps took over every node it wrote
+// to and snapshot cleans a list up first), so the refreshes below can
+// write in place.
+static void refresh_tree(node *n) {
+    if (!n) {
+        return;
+    }
+    STAT_COUNT(nodes);
+    refresh_tree(n->left);
+    refresh_tree(n->right);
+    refresh_data(n);
+    update(n);
+}
+
+// Rebuilds the subtree aggregates on top of up to date data aggregates.
+static void update_tree(node *n) {
+    if (!n) {
+        return;
+    }
+    STAT_COUNT(nodes);
+    update_tree(n->left);
+    update_tree(n->right);
+    update(n);
+}
+
+static void refresh_segs(void *arg, int lo, int hi) {
+    node **segs = (node **) arg;
+    for (int i = lo; i < hi; i++) {
+        refresh_data(segs[i]);
+    }
 }
 
 // Traverses list and returns the sum of the data values
 // of every node in the list.
 long sum_list(list *lst) {
-    if (!lst->head) {
+    STAT_OP(SUM);
+    if (!lst->root) {
         return 0L;
     }
-    long sum = 0L;
-    node *cur_node = lst->head;
-    do {
-        sum += 1L * cur_node->data;
-        cur_node = cur_node->next;
-    } while (cur_node != lst->head);
-    return sum;
+    sync_finger(lst);
+    if (lst->dirty && split_pass(lst)) {
+        // the values are summed in parallel, combining the per-node
+        // sums up the tree is cheap enough to leave on one thread
+        pool_run(refresh_segs, lst->segs, lst->num_segs);
+        update_tree(lst->root);
+        lst->dirty = 0;
+    } else if (lst->dirty) {
+        refresh_tree(lst->root);
+        lst->dirty = 0;
+    }
+    return lst->root->sum;
 }
 
+// Visits the values at physical positions [from, to) of the subtree
+// rooted at n, in descending order if backward is set. Nothing is pushed
+// down, so versions can be read without writing to them: mul and add
+// are the tags of n's ancestors, applied to the values on the way out.
+static void traverse_tree(node *n, unsigned long mul, unsigned long add,
+                          int from, int to, int backward, void (*visit)(int)) {
+    if (!n || from >= to) {
+        return;
+    }
+    STAT_COUNT(nodes);
+    // n's own tag applies first
+    add = mul * n->add + add;
+    mul = mul * n->mul;
+    int left_size = get_size(n->left);
+    int right_start = left_size + n->cnt;
+    int lo = from > left_size ? from - left_size : 0;
+    int hi = to < right_start ? to - left_size : n->cnt;
+    if (!backward) {
+        traverse_tree(n->left, mul, add, from, to, 0, visit);
+        for (int i = lo; i < hi; i++) {
+            (*visit)((int) (mul * (unsigned int) n->data[i] + add));
+        }
+        traverse_tree(n->right, mul, add, from - right_start,
+                      to - right_start, 0, visit);
+    } else {
+        traverse_tree(n->right, mul, add, from - right_start,
+                      to - right_start, 1, visit);
+        for (int i = hi - 1; i >= lo; i--) {
+            (*visit)((int) (mul * (unsigned int) n->data[i] + add));
+        }
+        traverse_tree(n->left, mul, add, from, to, 1, visit);
+    }
+}
+
+// Visits every value of the tree rooted at root in logical order.
+static void traverse_root(node *root, int head, int reversed,
+                          void (*visit)(int)) {
+    int len = root->size;
+    if (!reversed) {
+        traverse_tree(root, 1, 0, head, len, 0, visit);
+        traverse_tree(root, 1, 0, 0, head, 0, visit);
+    } else {
+        traverse_tree(root, 1, 0, 0, head + 1, 1, visit);
+        traverse_tree(root, 1, 0, head + 1, len, 1, visit);
+    }
+}
+
+// Calls visit on every data value from head to tail.
+void traverse_list(list *lst, void (*visit)(int)) {
+    STAT_OP(TRAVERSE);
+    if (!lst->root) {
+        return;
+    }
+    sync_finger(lst);
+    traverse_root(lst->root, lst->head_pos, lst->reversed, visit);
+}
+
+// Returns a read-only version of lst as it is now. This is O(1), unless
+// a non-affine map has left the aggregates stale and they have to be
+// rebuilt first. From then on the list copies any node it is about to
+// change that the version still points at.
+version *snapshot(list *lst) {
+    STAT_OP(SNAPSHOT);
+    // settles the finger's deferred updates and a dirty list's sums
+    sum_list(lst);
+    // the finger and the node index edit nodes in place
+    drop_finger(lst);
+    lst->num_segs = -1;
+    version *ver = (version *) malloc(sizeof(version));
+    ver->root = lst->root;
+    ver->head_pos = lst->head_pos;
+    ver->reversed = lst->reversed;
+    ver->mem = lst->mem;
+    if (ver->root) {
+        ver->root->refs++;
+    }
+    if (ver->mem) {
+        ver->mem->refs++;
+    }
+    return ver;
+}
+
+// Frees ver. Nodes only it pointed at go back to the list's free list.
+void release_version(version *ver) {
+    STAT_OP(RELEASE_VERSION);
+    free_tree(ver->mem, ver->root);
+    release_arena(ver->mem);
+    free(ver);
+}
+
+long sum_version(const version *ver) {
+    return ver->root ? ver->root->sum : 0L;
+}
+
+// Calls visit on every data value of ver from head to tail.
+void traverse_version(const version *ver, void (*visit)(int)) {
+    if (ver->root) {
+        traverse_root(ver->root, ver->head_pos, ver->reversed, visit);
+    }
+}
+
+// Appends the values of the subtree rooted at n to out in physical
+// order, returns the end of what was written.
+static int *gather_tree(node *n, unsigned long mul, unsigned long add,
+                        int *out) {
+    if (!n) {
+        return out;
+    }
+    add = mul * n->add + add;
+    mul = mul * n->mul;
+    out = gather_tree(n->left, mul, add, out);
+    for (int i = 0; i < n->cnt; i++) {
+        *out++ = (int) (mul * (unsigned int) n->data[i] + add);
+    }
+    return gather_tree(n->right, mul, add, out);
+}
+
+// Replaces the contents of dst with the values of ver. dst gets nodes of
+// its own, so it can be mapped or edited like any other list.
+void copy_version(const version *ver, list *dst) {
+    STAT_OP(COPY_VERSION);
+    reset_list(dst);
+    if (!ver->root) {
+        return;
+    }
+    int len = ver->root->size;
+    int *values = (int *) malloc(len * sizeof(int));
+    gather_tree(ver->root, 1, 0, values);
+    dst->root = build_tree(dst, values, len, 0);
+    dst->head_pos = ver->head_pos;
+    dst->reversed = ver->reversed;
+    free(values);
+}
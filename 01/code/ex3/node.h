@@ -4,19 +4,137 @@
     during grading so any changes in this file will be overwritten
 */
 
+// The list is backed by an implicit treap: nodes are ordered by their
+// position (in-order traversal gives the list from head to tail) and
+// kept balanced by random heap priorities, so positional ops are O(log n).
+//
+// Each node is unrolled: it packs up to NODE_CAP consecutive values so
+// traversals mostly stream through arrays instead of chasing pointers.
+// Build with -DNODE_CAP=1 to get one value per node.
+//
+// Every node also keeps the sum, min and max of its subtree so sum_list
+// is O(1), and affine maps are recorded as a pending mul/add tag that is
+// pushed down lazily. The aggregates always include the pending tag, data
+// and children only see it once it is pushed down.
+//
+// snapshot() hands out read-only versions of a list that share its
+// nodes. Nodes count how many parents (or roots) point at them, and a
+// mutation copies every shared node on the path it touches before
+// changing it, so a version never sees later edits.
+#ifndef NODE_CAP
+#define NODE_CAP 64
+#endif
+
 typedef struct NODE {
-    int data;
-    struct NODE *next;
+    int cnt;            // number of values packed in data
+    int refs;           // parents, lists and versions pointing at this
+    int size;           // number of values in this subtree
+    unsigned int prio;  // heap priority, larger is closer to the root
+    int min;            // smallest value in this subtree
+    int max;            // largest value in this subtree
+    int data_min;       // smallest value in data
+    int data_max;       // largest value in data
+    long sum;           // sum of the values in this subtree
+    long data_sum;      // sum of the values in data
+    unsigned long mul;  // pending x -> mul * x + add for data and children
+    unsigned long add;
+    struct NODE *left;
+    struct NODE *right;
+    int data[NODE_CAP];
 } node;
 
+// Nodes are carved out of per-list slabs instead of being malloc'd one
+// at a time; deleted nodes go on a free list for reuse and reset_list
+// hands whole slabs back in one go. A list's versions keep its slabs
+// alive, so they are only freed once the list has been reset and every
+// version released.
+#define SLAB_NODES 1024
+
+typedef struct SLAB {
+    struct SLAB *next;
+    node nodes[SLAB_NODES];
+} slab;
+
+typedef struct {
+    int refs;           // the list, if not reset yet, and its versions
+    slab *slabs;        // newest slab first
+    int slab_used;      // nodes handed out from the newest slab
+    node *free_nodes;   // recycled nodes, chained through right
+} arena;
+
+// Large maps and sum refreshes are split across the threads of pool.c.
+// They work on a flat index of the nodes, which is built on first use
+// and kept until an insert, delete or tag invalidates it. Lists with
+// fewer than PARALLEL_MIN values are always handled on one thread.
+#ifndef PARALLEL_MIN
+#define PARALLEL_MIN (1 << 16)
+#endif
+
+// Positional ops keep a finger on the node they last edited, with the
+// path from the root down to it. Edits that land in that node and do not
+// need a split or a merge are done in place. The size and sum updates
+// of its ancestors are deferred until something else needs the tree, so
+// a run of nearby edits costs O(1) each. Paths deeper than FINGER_DEPTH
+// just do not get a finger.
+#define FINGER_DEPTH 128
+
+// rotate_list and reverse_list never move values: the list only records
+// which physical position is the logical head and which way the logical
+// order runs, and positional ops translate their index through these.
 typedef struct {
-    node *head;
+    node *root;
+    int head_pos;       // physical index of the logical head
+    int reversed;       // 1 if the logical order runs backwards
+    int dirty;          // aggregates are stale after a non-affine map
+    arena *mem;         // where nodes come from, NULL until the first
+                        // node is allocated
+    node **segs;        // every node in order, with no pending tags
+    int num_segs;       // nodes in segs, -1 if segs is out of date
+    int segs_cap;       // room in segs
+    node *finger;       // last edited node, NULL if none
+    int finger_start;   // physical index of finger->data[0]
+    int finger_depth;   // nodes in finger_path, the finger included
+    int finger_delta;   // size change not yet applied to the ancestors
+    int finger_stale;   // 1 if the ancestors' aggregates are out of date
+    unsigned int prio_state;    // treap priority generator
+    node *finger_path[FINGER_DEPTH];    // root first
 } list;
 
+// A read-only version of a list as it was when snapshot() was called.
+// Reading a version never writes to its nodes, so other threads may sum
+// and traverse it while the list keeps changing. Taking and releasing
+// versions must be done by the thread that mutates the list.
+typedef struct {
+    node *root;
+    int head_pos;
+    int reversed;
+    arena *mem;
+} version;
+
+// One step of a fused map: func, or x -> mul * x + add if func is NULL.
+typedef struct {
+    int (*func)(int);
+    int mul;
+    int add;
+} map_step;
+
+void init_list(list *lst);
+
 void insert_node_at(list *lst, int index, int data);
 void delete_node_at(list *lst, int index);
+void insert_many(list *lst, int index, const int *values, int n);
+void delete_range(list *lst, int index, int n);
 void rotate_list(list *lst, int offset);
 void reverse_list(list *lst);
 void reset_list(list *lst);
 void map(list *lst, int (*func)(int));
+void map_affine(list *lst, int mul, int add);
+void map_steps(list *lst, const map_step *steps, int num_steps);
 long sum_list(list *list);
+void traverse_list(list *lst, void (*visit)(int));
+version *snapshot(list *lst);
+void release_version(version *ver);
+long sum_version(const version *ver);
+void traverse_version(const version *ver, void (*visit)(int));
+void copy_version(const version *ver, list *dst);
+void dump_list_stats(void);
@@ -0,0 +1,124 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+
+static int num_parts = 0;       // configured thread count, 0 if unset
+static int num_workers = 0;     // workers started so far
+static unsigned long job_id = 0;
+static int job_pending = 0;     // workers yet to finish the current job
+
+// The current job, only written while every worker is idle
+static void (*job_work)(void *, int, int);
+static void *job_arg;
+static int job_n;
+static int job_parts;
+
+// Runs part i of the current job.
+static void run_part(int i) {
+    int lo = (int) ((long) job_n * i / job_parts);
+    int hi = (int) ((long) job_n * (i + 1) / job_parts);
+    if (lo < hi) {
+        job_work(job_arg, lo, hi);
+    }
+}
+
+static void *worker(void *arg) {
+    int id = (int) (long) arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (job_id == seen) {
+            pthread_cond_wait(&job_ready, &pool_lock);
+        }
+        seen = job_id;
+        pthread_mutex_unlock(&pool_lock);
+        if (id < job_parts) {
+            run_part(id);
+        }
+        pthread_mutex_lock(&pool_lock);
+        if (--job_pending == 0) {
+            pthread_cond_signal(&job_done);
+        }
+    }
+    return NULL;
+}
+
+void set_pool_threads(int num_threads) {
+    if (num_threads > POOL_MAX_THREADS) {
+        num_threads = POOL_MAX_THREADS;
+    }
+    num_parts = num_threads > 0 ? num_threads : 0;
+}
+
+int pool_threads(void) {
+    if (!num_parts) {
+        const char *env = getenv("LIST_THREADS");
+        long n = env ? atol(env) : 0;
+        if (n <= 0) {
+            n = sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (n < 1) {
+            n = 1;
+        }
+        set_pool_threads((int) n);
+    }
+    return num_parts;
+}
+
+void pool_run(void (*work)(void *, int, int), void *arg, int n) {
+    int parts = pool_threads();
+    if (parts > n) {
+        parts = n;
+    }
+    if (parts <= 1) {
+        work(arg, 0, n);
+        return;
+    }
+    // workers from an earlier, larger setting stay around and sit the
+    // job out
+    while (num_workers < parts - 1) {
+        pthread_t tid;
+        void *id = (void *) (long) (num_workers + 1);
+        if (pthread_create(&tid, NULL, worker, id)) {
+            break;
+        }
+        pthread_detach(tid);
+        num_workers++;
+    }
+    if (num_workers < parts - 1) {
+        parts = num_workers + 1;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    job_work = work;
+    job_arg = arg;
+    job_n = n;
+    job_parts = parts;
+    job_pending = num_workers;
+    job_id++;
+    pthread_cond_broadcast(&job_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_part(0);
+
+    pthread_mutex_lock(&pool_lock);
+    while (job_pending) {
+        pthread_cond_wait(&job_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
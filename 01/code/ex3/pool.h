@@ -0,0 +1,22 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// A process-wide pool of worker threads for splitting a loop over
+// [0, n) into contiguous parts. The workers are started on first use
+// and then sleep between jobs. The calling thread always runs the
+// first part itself.
+#define POOL_MAX_THREADS 64
+
+// Sets the number of threads jobs are split across (including the
+// caller), 0 goes back to the default: LIST_THREADS from the
+// environment if set, otherwise the number of online CPUs.
+void set_pool_threads(int num_threads);
+int pool_threads(void);
+
+// Calls work(arg, lo, hi) on disjoint ranges covering [0, n) and
+// returns once every range is done.
+void pool_run(void (*work)(void *, int, int), void *arg, int n);
@@ -0,0 +1,173 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "reader.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BLOCK_SIZE (1 << 20)
+// refill before parsing once fewer bytes than this are left, so a
+// number is never split across two reads
+#define MIN_LOOKAHEAD 64
+
+// Moves the unparsed bytes to the front of the block and reads more
+// behind them.
+static void refill(reader *r) {
+    size_t left = r->len - r->pos;
+    memmove(r->block, r->block + r->pos, left);
+    r->pos = 0;
+    r->len = left;
+    while (!r->eof && r->len < BLOCK_SIZE) {
+        ssize_t got = read(r->fd, r->block + r->len, BLOCK_SIZE - r->len);
+        if (got <= 0) {
+            r->eof = 1;
+            break;
+        }
+        r->len += got;
+        if (r->len >= MIN_LOOKAHEAD) {
+            break;
+        }
+    }
+}
+
+// Skips the magic header if the input is a binary trace.
+static void detect_binary(reader *r) {
+    if (r->len >= BINARY_MAGIC_LEN
+        && !memcmp(r->buf, BINARY_MAGIC, BINARY_MAGIC_LEN)) {
+        r->binary = 1;
+        r->pos = BINARY_MAGIC_LEN;
+    }
+}
+
+// Reads from fd, which is mmapped if it refers to a regular file.
+void reader_init(reader *r, int fd) {
+    struct stat st;
+    r->fd = fd;
+    r->pos = 0;
+    r->len = 0;
+    r->eof = 0;
+    r->mapped = 0;
+    r->binary = 0;
+    r->block = NULL;
+    r->buf = NULL;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            posix_madvise(map, st.st_size, POSIX_MADV_SEQUENTIAL);
+            r->buf = map;
+            r->len = st.st_size;
+            r->mapped = 1;
+            r->eof = 1;
+            detect_binary(r);
+            return;
+        }
+    }
+    r->block = (char *) malloc(BLOCK_SIZE);
+    r->buf = r->block;
+    refill(r);
+    detect_binary(r);
+}
+
+// Opens fname for reading, returns 0 if it cannot be opened.
+int reader_open(reader *r, const char *fname) {
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    reader_init(r, fd);
+    return 1;
+}
+
+static int is_space(char c) {
+    return c == ' ' || (unsigned char) (c - '\t') <= '\r' - '\t';
+}
+
+// Decodes one zigzag varint operand.
+static int read_varint(reader *r, int *val) {
+    if (!r->eof && r->len - r->pos < MIN_LOOKAHEAD) {
+        refill(r);
+    }
+    unsigned int num = 0;
+    int shift = 0;
+    while (r->pos < r->len && shift < 35) {
+        unsigned char byte = r->buf[r->pos++];
+        num |= (unsigned int) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *val = (int) ((num >> 1) ^ (0u - (num & 1)));
+            return 1;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+// Reads the next opcode into op. Returns 0 at the end of input.
+int read_op(reader *r, int *op) {
+    if (!r->binary) {
+        return read_int(r, op);
+    }
+    if (!r->eof && r->len - r->pos < MIN_LOOKAHEAD) {
+        refill(r);
+    }
+    if (r->pos == r->len) {
+        return 0;
+    }
+    *op = (unsigned char) r->buf[r->pos++];
+    return 1;
+}
+
+// Parses the next integer into val. Returns 1 on success and 0 at the
+// end of input or on anything that is not a number, like scanf would.
+int read_int(reader *r, int *val) {
+    if (r->binary) {
+        return read_varint(r, val);
+    }
+    for (;;) {
+        if (!r->eof && r->len - r->pos < MIN_LOOKAHEAD) {
+            refill(r);
+        }
+        if (r->pos == r->len) {
+            return 0;
+        }
+        if (!is_space(r->buf[r->pos])) {
+            break;
+        }
+        r->pos++;
+    }
+    const char *p = r->buf + r->pos;
+    const char *end = r->buf + r->len;
+    int negative = *p == '-';
+    p += negative || *p == '+';
+    const char *digits = p;
+    unsigned int num = 0;
+    unsigned int digit;
+    while (p < end && (digit = (unsigned char) *p - '0') < 10) {
+        num = num * 10 + digit;
+        p++;
+    }
+    if (p == digits) {
+        return 0;
+    }
+    r->pos = p - r->buf;
+    *val = (int) (negative ? 0u - num : num);
+    return 1;
+}
+
+void reader_close(reader *r) {
+    if (r->mapped) {
+        munmap((void *) r->buf, r->len);
+    }
+    free(r->block);
+    close(r->fd);
+}
@@ -0,0 +1,35 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+#include <stddef.h>
+
+// Reads whitespace separated integers without going through stdio.
+// Regular files are mmapped and parsed in place, anything else (pipes,
+// terminals) is read in large blocks into a buffer that is refilled as
+// it drains.
+//
+// Input starting with BINARY_MAGIC is a binary trace instead: each
+// instruction is a one byte opcode followed by its operands as zigzag
+// LEB128 varints. trace_conv converts between the two formats.
+#define BINARY_MAGIC "L1OP"
+#define BINARY_MAGIC_LEN 4
+typedef struct {
+    int fd;
+    const char *buf;    // mapped file or the block buffer
+    size_t len;         // bytes available in buf
+    size_t pos;         // next byte to parse
+    int mapped;         // 1 if buf is an mmap of the whole file
+    int eof;            // 1 once fd has nothing more to read
+    int binary;         // 1 if the input is a binary trace
+    char *block;        // owned buffer when not mapped
+} reader;
+
+int reader_open(reader *r, const char *fname);
+void reader_init(reader *r, int fd);
+int read_op(reader *r, int *op);
+int read_int(reader *r, int *val);
+void reader_close(reader *r);
@@ -0,0 +1,97 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Converts list traces between the text format (sample.in) and the
+// binary format described in reader.h. The input format is detected, the
+// output is always the other one:
+//     ./trace_conv big_test.in big_test.bin
+//     ./trace_conv big_test.bin big_test.txt
+// With -t every instruction is tagged with a list id first, as mex3
+// expects.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reader.h"
+
+// Operands taken by each opcode, shared by the ex2 and ex3 runners (7
+// to 9 are ex3 only). INSERT_MANY is followed by as many more values
+// as its second operand says.
+static const int num_operands[] = { 0, 2, 1, 1, 0, 0, 1, 2, 2, 0 };
+#define INSERT_MANY 7
+#define NUM_OPCODES (int) (sizeof(num_operands) / sizeof(num_operands[0]))
+
+static void write_varint(FILE *out, int val) {
+    // zigzag so small negative numbers stay short
+    unsigned int num = ((unsigned int) val << 1) ^ (0u - ((unsigned int) val >> 31));
+    while (num >= 0x80) {
+        putc((num & 0x7f) | 0x80, out);
+        num >>= 7;
+    }
+    putc(num, out);
+}
+
+int main(int argc, char **argv) {
+    int tagged = argc == 4 && !strcmp(argv[1], "-t");
+    if (argc != 3 + tagged) {
+        fprintf(stderr, "Usage: %s [-t] <input trace> <output trace>\n",
+                argv[0]);
+        exit(1);
+    }
+    reader in;
+    if (!reader_open(&in, argv[1 + tagged])) {
+        fprintf(stderr, "Error reading file %s\n", argv[1 + tagged]);
+        exit(1);
+    }
+    FILE *out = fopen(argv[2 + tagged], "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error writing file %s\n", argv[2 + tagged]);
+        exit(1);
+    }
+    int to_binary = !in.binary;
+    if (to_binary) {
+        fwrite(BINARY_MAGIC, 1, BINARY_MAGIC_LEN, out);
+    }
+    int id, op, val;
+    while ((!tagged || read_int(&in, &id)) && read_op(&in, &op)) {
+        if (op < 0 || op >= NUM_OPCODES) {
+            fprintf(stderr, "Unknown opcode %d\n", op);
+            exit(1);
+        }
+        if (tagged && to_binary) {
+            write_varint(out, id);
+        } else if (tagged) {
+            fprintf(out, "%d ", id);
+        }
+        if (to_binary) {
+            putc(op, out);
+        } else {
+            fprintf(out, "%d", op);
+        }
+        int count = num_operands[op];
+        for (int i = 0; i < count; i++) {
+            if (!read_int(&in, &val)) {
+                fprintf(stderr, "Missing operand for opcode %d\n", op);
+                exit(1);
+            }
+            if (to_binary) {
+                write_varint(out, val);
+            } else {
+                fprintf(out, " %d", val);
+            }
+            if (op == INSERT_MANY && i == 1 && val > 0) {
+                count += val;
+            }
+        }
+        if (!to_binary) {
+            putc('\n', out);
+        }
+    }
+    reader_close(&in);
+    fclose(out);
+}
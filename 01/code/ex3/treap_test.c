@@ -0,0 +1,83 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Checks that the tree behind a list stays a treap, every node's
+// priority at most its parent's, through a mix of single inserts (which
+// split full nodes), bulk splices, deletes, rotations and reversals, and
+// that its depth stays logarithmic.
+//     make check    (or ./treap_test [seed])
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "node.h"
+
+#define OPS 400000
+
+static int out_of_order;
+static int num_nodes;
+
+// Returns the depth of t, counting nodes that outrank their parent.
+static int check_tree(const node *t, unsigned int parent_prio) {
+    if (!t) {
+        return 0;
+    }
+    num_nodes++;
+    if (t->prio > parent_prio) {
+        out_of_order++;
+    }
+    int left = check_tree(t->left, t->prio);
+    int right = check_tree(t->right, t->prio);
+    return 1 + (left > right ? left : right);
+}
+
+int main(int argc, char **argv) {
+    srand(argc > 1 ? atoi(argv[1]) : 2106);
+    list lst;
+    init_list(&lst);
+    int values[64] = { 0 };
+    for (int op = 0; op < OPS; op++) {
+        int len = lst.root ? lst.root->size + lst.finger_delta : 0;
+        int r = rand() % 20;
+        if (r < 6) {
+            insert_node_at(&lst, len, op);
+        } else if (r < 8) {
+            insert_node_at(&lst, 0, op);
+        } else if (r < 12) {
+            insert_node_at(&lst, rand() % (len + 1), op);
+        } else if (r < 13) {
+            insert_many(&lst, rand() % (len + 1), values, 1 + rand() % 64);
+        } else if (r < 15 && len) {
+            delete_node_at(&lst, rand() % len);
+        } else if (r < 16 && len > 8) {
+            delete_range(&lst, rand() % (len - 8), 1 + rand() % 8);
+        } else if (r < 17 && len) {
+            rotate_list(&lst, rand() % len);
+        } else if (r < 18) {
+            reverse_list(&lst);
+        } else {
+            // settles any edits pending on the finger
+            sum_list(&lst);
+        }
+    }
+    sum_list(&lst);
+
+    int depth = check_tree(lst.root, ~0u);
+    int log_nodes = 0;
+    while (1 << log_nodes < num_nodes) {
+        log_nodes++;
+    }
+    reset_list(&lst);
+    // a random treap is about 3 log2(n) deep
+    if (out_of_order || depth > 5 * log_nodes) {
+        fprintf(stderr, "treap_test: %d of %d nodes out of order, depth %d\n",
+                out_of_order, num_nodes, depth);
+        return 1;
+    }
+    printf("treap_test ok\n");
+    return 0;
+}
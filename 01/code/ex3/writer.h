@@ -0,0 +1,17 @@
+/*************************************
+* Lab 1 Exercise 3
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Buffered stdout for the runners. Numbers are formatted by hand into a
+// set of large blocks which are only handed to the kernel, all at once
+// with writev, when every block is full or flush_output is called.
+// Nothing else may write to stdout while output is buffered here.
+// A write that fails for any reason but a signal ends the program.
+void print_int(int val);
+void print_long(long val);
+void print_char(char c);
+void print_str(const char *str);
+void flush_output(void);
@@ -0,0 +1,609 @@
+/*************************************
+* Lab 1 Exercise 5
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Prints the same report as check_system.sh without spawning anything:
+// the host comes from uname(2), the process limit from getrlimit(2), the
+// memory figures from /proc/meminfo, and the processes of every user
+// are counted in one pass over /proc/<pid>/status.
+//
+// With -i it keeps sampling instead, every given number of milliseconds:
+//     ./sysprobe -i ms [-n ring] [-c count] [-o file]
+// The last ring samples (default 3600) are kept in memory and written
+// out as a time series on SIGUSR1, and on exit after count samples or
+// SIGINT/SIGTERM. The /proc files stay open between samples and are
+// re-read with pread, so a sample costs no process spawns and, once the
+// set of processes settles, no opens either.
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <time.h>
+#include <unistd.h>
+
+// Busiest users kept per sample
+#define SAMPLE_USERS 8
+#define NAME_LEN 33
+
+// Processes per effective uid, in an open addressing table
+typedef struct {
+    unsigned int *uids;
+    int *counts;        // 0 marks an empty slot
+    int cap;            // a power of two
+    int used;
+} uid_table;
+
+typedef struct {
+    long mem_total, mem_free;
+    long swap_total, swap_free;
+} mem_info;
+
+// Open /proc/<pid>/status files by pid, in an open addressing table.
+// A pid of 0 marks an empty slot, an fd of -1 one handed on to the
+// table of the next scan.
+typedef struct {
+    int *pids;
+    int *fds;
+    int cap;            // a power of two
+    int used;
+} fd_table;
+
+// User names by uid, looked up once per uid
+typedef struct {
+    unsigned int *uids;
+    char (*names)[NAME_LEN];
+    int cap;            // a power of two
+    int used;
+} name_table;
+
+// Everything kept open from one sample to the next
+typedef struct {
+    DIR *proc;
+    int meminfo;
+    int max_fd;         // status fds from here on are not kept open
+    fd_table status;
+    name_table names;
+    uid_table users;
+} probe;
+
+typedef struct {
+    struct timespec when;
+    double mem_free;        // percentages
+    double swap_free;
+    int own_procs;          // processes of the user running the probe
+    int num_users;          // users with processes, may be more than kept
+    unsigned int uids[SAMPLE_USERS];    // busiest first, the top user first
+    int counts[SAMPLE_USERS];
+} sample;
+
+static volatile sig_atomic_t dump_requested = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static unsigned int hash_uid(unsigned int uid) {
+    return uid * 2654435761u;
+}
+
+static void table_add(uid_table *t, unsigned int uid, int count);
+
+static void table_grow(uid_table *t) {
+    uid_table old = *t;
+    t->cap = old.cap ? 2 * old.cap : 64;
+    t->uids = (unsigned int *) malloc(t->cap * sizeof(unsigned int));
+    t->counts = (int *) calloc(t->cap, sizeof(int));
+    t->used = 0;
+    for (int i = 0; i < old.cap; i++) {
+        if (old.counts[i]) {
+            table_add(t, old.uids[i], old.counts[i]);
+        }
+    }
+    free(old.uids);
+    free(old.counts);
+}
+
+static void table_add(uid_table *t, unsigned int uid, int count) {
+    // keep the table at most half full
+    if (2 * (t->used + 1) > t->cap) {
+        table_grow(t);
+    }
+    unsigned int i = hash_uid(uid) & (t->cap - 1);
+    while (t->counts[i] && t->uids[i] != uid) {
+        i = (i + 1) & (t->cap - 1);
+    }
+    if (!t->counts[i]) {
+        t->uids[i] = uid;
+        t->used++;
+    }
+    t->counts[i] += count;
+}
+
+static int table_get(const uid_table *t, unsigned int uid) {
+    if (!t->cap) {
+        return 0;
+    }
+    unsigned int i = hash_uid(uid) & (t->cap - 1);
+    while (t->counts[i]) {
+        if (t->uids[i] == uid) {
+            return t->counts[i];
+        }
+        i = (i + 1) & (t->cap - 1);
+    }
+    return 0;
+}
+
+// Reads the start of the file open at fd into buf as a string. Returns
+// the length read, or -1 if it can no longer be read.
+static int pread_file(int fd, char *buf, int size) {
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    if (len < 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+    return (int) len;
+}
+
+// Returns the number after key in a "Key: value" file, 0 if missing.
+static long field(const char *buf, const char *key) {
+    const char *p = strstr(buf, key);
+    return p ? strtol(p + strlen(key), NULL, 10) : 0;
+}
+
+static int read_meminfo(probe *pr, mem_info *mem) {
+    char buf[8192];
+    if (pread_file(pr->meminfo, buf, sizeof(buf)) < 0) {
+        return 0;
+    }
+    mem->mem_total = field(buf, "MemTotal:");
+    mem->mem_free = field(buf, "MemFree:");
+    mem->swap_total = field(buf, "SwapTotal:");
+    mem->swap_free = field(buf, "SwapFree:");
+    return 1;
+}
+
+static unsigned int hash_pid(int pid) {
+    return (unsigned int) pid * 2654435761u;
+}
+
+// Returns the slot of pid in t, or the empty slot it would go in.
+static int fd_slot(const fd_table *t, int pid) {
+    unsigned int i = hash_pid(pid) & (t->cap - 1);
+    while (t->pids[i] && t->pids[i] != pid) {
+        i = (i + 1) & (t->cap - 1);
+    }
+    return (int) i;
+}
+
+// Sets up t empty with room for n pids at most half full.
+static void fd_table_init(fd_table *t, int n) {
+    t->cap = 64;
+    while (t->cap < 2 * n) {
+        t->cap *= 2;
+    }
+    t->pids = (int *) calloc(t->cap, sizeof(int));
+    t->fds = (int *) malloc(t->cap * sizeof(int));
+    t->used = 0;
+}
+
+static void fd_table_put(fd_table *t, int pid, int fd) {
+    if (2 * (t->used + 1) > t->cap) {
+        fd_table bigger;
+        fd_table_init(&bigger, t->used + 1);
+        for (int i = 0; i < t->cap; i++) {
+            if (t->pids[i]) {
+                fd_table_put(&bigger, t->pids[i], t->fds[i]);
+            }
+        }
+        free(t->pids);
+        free(t->fds);
+        *t = bigger;
+    }
+    int i = fd_slot(t, pid);
+    t->pids[i] = pid;
+    t->fds[i] = fd;
+    t->used++;
+}
+
+// Closes every fd still in t and frees it.
+static void fd_table_close(fd_table *t) {
+    for (int i = 0; i < t->cap; i++) {
+        if (t->pids[i] && t->fds[i] >= 0) {
+            close(t->fds[i]);
+        }
+    }
+    free(t->pids);
+    free(t->fds);
+}
+
+// Reads the status of pid into buf, reusing the fd of the last scan if
+// there is one. Returns the fd to keep, or -1 if the process is gone.
+static int read_status(probe *pr, fd_table *last, int pid, char *buf,
+                       int size) {
+    int fd = -1;
+    if (last->cap) {
+        int i = fd_slot(last, pid);
+        if (last->pids[i]) {
+            fd = last->fds[i];
+            last->fds[i] = -1;
+        }
+    }
+    if (fd >= 0 && pread_file(fd, buf, size) >= 0) {
+        return fd;
+    }
+    // the process we had open is gone, but its pid may be in use again
+    if (fd >= 0) {
+        close(fd);
+    }
+    char path[32];
+    snprintf(path, sizeof(path), "%d/status", pid);
+    fd = openat(dirfd(pr->proc), path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (pread_file(fd, buf, size) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Counts every process under /proc by its effective uid, the owner ps
+// reports, into pr->users. Processes that exit mid-scan are skipped.
+static void count_processes(probe *pr) {
+    uid_table *t = &pr->users;
+    if (t->cap) {
+        memset(t->counts, 0, t->cap * sizeof(int));
+        t->used = 0;
+    }
+    fd_table last = pr->status;
+    fd_table_init(&pr->status, last.used);
+    rewinddir(pr->proc);
+    struct dirent *ent;
+    // the Uid line comes well before the end of the first kilobyte
+    char buf[1024];
+    while ((ent = readdir(pr->proc))) {
+        if (ent->d_name[0] < '1' || ent->d_name[0] > '9') {
+            continue;
+        }
+        int pid = atoi(ent->d_name);
+        int fd = read_status(pr, &last, pid, buf, sizeof(buf));
+        if (fd < 0) {
+            continue;
+        }
+        // past the fd limit, fall back to opening the file every time
+        if (fd < pr->max_fd) {
+            fd_table_put(&pr->status, pid, fd);
+        } else {
+            close(fd);
+        }
+        // Uid: real effective saved fs
+        const char *p = strstr(buf, "\nUid:");
+        if (!p) {
+            continue;
+        }
+        char *end;
+        strtoul(p + 5, &end, 10);
+        table_add(t, (unsigned int) strtoul(end, NULL, 10), 1);
+    }
+    // whatever the last scan had open and this one did not see has exited
+    if (last.cap) {
+        fd_table_close(&last);
+    }
+}
+
+// Returns the slot of uid in t, or the empty slot it would go in.
+static unsigned int name_slot(const name_table *t, unsigned int uid) {
+    unsigned int i = hash_uid(uid) & (t->cap - 1);
+    while (t->names[i][0] && t->uids[i] != uid) {
+        i = (i + 1) & (t->cap - 1);
+    }
+    return i;
+}
+
+// Returns the name of uid, or its number if it has no entry. The name
+// stays valid until the next lookup of a uid not seen before.
+static const char *user_name(probe *pr, unsigned int uid) {
+    name_table *t = &pr->names;
+    unsigned int i = 0;
+    if (t->cap) {
+        i = name_slot(t, uid);
+        if (t->names[i][0]) {
+            return t->names[i];
+        }
+    }
+    if (2 * (t->used + 1) > t->cap) {
+        name_table old = *t;
+        t->cap = old.cap ? 2 * old.cap : 64;
+        t->uids = (unsigned int *) malloc(t->cap * sizeof(unsigned int));
+        t->names = (char (*)[NAME_LEN]) calloc(t->cap, NAME_LEN);
+        for (int k = 0; k < old.cap; k++) {
+            if (old.names[k][0]) {
+                unsigned int j = name_slot(t, old.uids[k]);
+                t->uids[j] = old.uids[k];
+                memcpy(t->names[j], old.names[k], NAME_LEN);
+            }
+        }
+        free(old.uids);
+        free(old.names);
+        i = name_slot(t, uid);
+    }
+    struct passwd *pw = getpwuid(uid);
+    if (pw) {
+        snprintf(t->names[i], NAME_LEN, "%s", pw->pw_name);
+    } else {
+        snprintf(t->names[i], NAME_LEN, "%u", uid);
+    }
+    t->uids[i] = uid;
+    t->used++;
+    return t->names[i];
+}
+
+// Returns 1 if user a should come before user b in a sample:
+// more processes first and, like sort | uniq -c | sort -n | tail -1,
+// the name that sorts last first among equals.
+static int busier(probe *pr, unsigned int uid_a, int count_a,
+                  unsigned int uid_b, int count_b) {
+    if (count_a != count_b) {
+        return count_a > count_b;
+    }
+    // looking up b may move the table a's name is in
+    char name_a[NAME_LEN];
+    memcpy(name_a, user_name(pr, uid_a), NAME_LEN);
+    return strcmp(name_a, user_name(pr, uid_b)) > 0;
+}
+
+// Takes one sample of memory and processes.
+static void take_sample(probe *pr, sample *s) {
+    clock_gettime(CLOCK_REALTIME, &s->when);
+    mem_info mem = { 0, 0, 0, 0 };
+    read_meminfo(pr, &mem);
+    // as awk would print them, nan included when there is no swap at all
+    s->mem_free = (double) mem.mem_free / mem.mem_total * 100.0;
+    s->swap_free = (double) mem.swap_free / mem.swap_total * 100.0;
+
+    count_processes(pr);
+    uid_table *t = &pr->users;
+    s->own_procs = table_get(t, geteuid());
+    s->num_users = 0;
+    int kept = 0;
+    for (int i = 0; i < t->cap; i++) {
+        if (!t->counts[i]) {
+            continue;
+        }
+        s->num_users++;
+        // insertion into the busiest SAMPLE_USERS so far
+        int k = kept < SAMPLE_USERS ? kept++ : SAMPLE_USERS;
+        while (k > 0 && busier(pr, t->uids[i], t->counts[i], s->uids[k - 1],
+                               s->counts[k - 1])) {
+            if (k < SAMPLE_USERS) {
+                s->uids[k] = s->uids[k - 1];
+                s->counts[k] = s->counts[k - 1];
+            }
+            k--;
+        }
+        if (k < SAMPLE_USERS) {
+            s->uids[k] = t->uids[i];
+            s->counts[k] = t->counts[i];
+        }
+    }
+}
+
+// Opens what every sample reads. With keep_open the status file of
+// every process stays open for the next sample too; a single sample
+// opens, reads and closes each one.
+static int open_probe(probe *pr, int keep_open) {
+    memset(pr, 0, sizeof(probe));
+    // every process takes an fd, so ask for as many as we may have and
+    // leave a few for everything else
+    struct rlimit limit;
+    pr->max_fd = 0;
+    if (keep_open && !getrlimit(RLIMIT_NOFILE, &limit)) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        pr->max_fd = limit.rlim_cur > 1 << 30 ? 1 << 30
+                                              : (int) limit.rlim_cur - 16;
+    }
+    pr->proc = opendir("/proc");
+    pr->meminfo = open("/proc/meminfo", O_RDONLY);
+    return pr->proc && pr->meminfo >= 0;
+}
+
+static void close_probe(probe *pr) {
+    if (pr->status.cap) {
+        fd_table_close(&pr->status);
+    }
+    if (pr->proc) {
+        closedir(pr->proc);
+    }
+    if (pr->meminfo >= 0) {
+        close(pr->meminfo);
+    }
+    free(pr->names.uids);
+    free(pr->names.names);
+    free(pr->users.uids);
+    free(pr->users.counts);
+}
+
+// Prints the report check_system.sh prints, from one sample.
+static void print_report(probe *pr, const sample *s) {
+    struct utsname host;
+    uname(&host);
+
+    struct rlimit limit;
+    char max_procs[32] = "unlimited";
+    if (!getrlimit(RLIMIT_NPROC, &limit) && limit.rlim_cur != RLIM_INFINITY) {
+        snprintf(max_procs, sizeof(max_procs), "%llu",
+                 (unsigned long long) limit.rlim_cur);
+    }
+
+    printf("Hostname: %s\n", host.nodename);
+    // uname -i is not in uname(2); it is the machine on most systems
+    printf("Machine Hardware: %s %s\n", host.sysname, host.machine);
+    printf("Max User Processes: %s\n", max_procs);
+    printf("User Processes: %d\n", s->own_procs);
+    printf("User With Most Processes: %s\n",
+           s->num_users ? user_name(pr, s->uids[0]) : "");
+    printf("Memory Free (%%): %.6g\n", s->mem_free);
+    printf("Swap Free (%%): %.6g\n", s->swap_free);
+}
+
+// Writes the samples in ring order, oldest first, one line each:
+// the time, memory and swap free in %, the user's own processes, then
+// user:count for the busiest users.
+static void dump_samples(probe *pr, FILE *out, const sample *ring,
+                         int ring_len, long taken) {
+    fprintf(out, "# time mem_free%% swap_free%% user_procs users"
+            " busiest:count...\n");
+    long first = taken > ring_len ? taken - ring_len : 0;
+    for (long n = first; n < taken; n++) {
+        const sample *s = &ring[n % ring_len];
+        fprintf(out, "%ld.%03ld %.6g %.6g %d %d", (long) s->when.tv_sec,
+                s->when.tv_nsec / 1000000, s->mem_free, s->swap_free,
+                s->own_procs, s->num_users);
+        int kept = s->num_users < SAMPLE_USERS ? s->num_users : SAMPLE_USERS;
+        for (int k = 0; k < kept; k++) {
+            fprintf(out, " %s:%d", user_name(pr, s->uids[k]), s->counts[k]);
+        }
+        fputc('\n', out);
+    }
+    fflush(out);
+}
+
+static void on_dump(int sig) {
+    (void) sig;
+    dump_requested = 1;
+}
+
+static void on_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+}
+
+// Samples every interval_ms until count samples are taken (forever if
+// count is 0) or a stop signal arrives.
+static void run_sampler(probe *pr, long interval_ms, int ring_len,
+                        long count, FILE *out) {
+    sample *ring = (sample *) malloc(ring_len * sizeof(sample));
+    long taken = 0;
+
+    // no SA_RESTART, so the signals cut the sleep short
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = on_dump;
+    sigaction(SIGUSR1, &sa, NULL);
+    sa.sa_handler = on_stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    // sleep to absolute deadlines so the sampling cost does not add up
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (!stop_requested) {
+        take_sample(pr, &ring[taken % ring_len]);
+        taken++;
+        if (count && taken == count) {
+            break;
+        }
+        next.tv_sec += interval_ms / 1000;
+        next.tv_nsec += interval_ms % 1000 * 1000000;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000;
+        }
+        // the flags are checked after every sample and every interrupted
+        // sleep; only a signal landing just before a sleep starts waits
+        // for that interval to run out
+        for (;;) {
+            if (dump_requested) {
+                dump_requested = 0;
+                dump_samples(pr, out, ring, ring_len, taken);
+            }
+            if (stop_requested
+                || clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next,
+                                   NULL) != EINTR) {
+                break;
+            }
+        }
+    }
+    dump_samples(pr, out, ring, ring_len, taken);
+    free(ring);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-i ms [-n ring] [-c count] [-o file]]\n",
+            prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    long interval_ms = 0;
+    int ring_len = 3600;
+    long count = 0;
+    const char *out_name = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "i:n:c:o:")) != -1) {
+        switch (opt) {
+            case 'i':
+                interval_ms = atol(optarg);
+                if (interval_ms < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'n':
+                ring_len = atoi(optarg);
+                if (ring_len < 1) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'c':
+                count = atol(optarg);
+                if (count < 0) {
+                    usage(argv[0]);
+                }
+                break;
+            case 'o':
+                out_name = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+    }
+
+    probe pr;
+    if (!open_probe(&pr, interval_ms != 0)) {
+        fprintf(stderr, "Error: cannot read /proc\n");
+        exit(1);
+    }
+    if (!interval_ms) {
+        sample s;
+        take_sample(&pr, &s);
+        print_report(&pr, &s);
+        close_probe(&pr);
+        return 0;
+    }
+    FILE *out = out_name ? fopen(out_name, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Error: cannot write %s\n", out_name);
+        exit(1);
+    }
+    run_sampler(&pr, interval_ms, ring_len, count, out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    close_probe(&pr);
+    return 0;
+}
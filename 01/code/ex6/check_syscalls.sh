@@ -9,9 +9,11 @@
 
 echo "Printing system call report"
 
-# Compile file
+# Compile file and the syscall profiler
 gcc -std=c99 pid_checker.c -o ex6
+gcc -std=c99 -Wall -Wextra -shared -fPIC sysprof.c -o sysprof.so -ldl
 
-# Use strace to get report
-strace -c ./ex6
+# Count syscalls in process instead of under strace -c; calls libc makes
+# internally (the write behind printf) are not seen, see sysprof.c
+LD_PRELOAD=./sysprof.so ./ex6
 
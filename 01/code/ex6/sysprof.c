@@ -0,0 +1,511 @@
+/*************************************
+* Lab 1 Exercise 6
+* Name: Rohit Rajesh Bhat
+* Student No: A0214231Y
+* Lab Group: 06
+*************************************/
+
+// Counts system calls from inside the process instead of through ptrace:
+// build it as a shared object and preload it,
+//     gcc -std=c99 -Wall -Wextra -shared -fPIC sysprof.c -o sysprof.so -ldl
+//     LD_PRELOAD=./sysprof.so ./ex6
+// and it prints a table like strace -c's on exit, to stderr or to the
+// file named by SYSPROF_OUT.
+//
+// Every libc wrapper in the tables below is replaced by one that times
+// the real wrapper (found with dlsym(RTLD_NEXT)) and counts its calls and
+// failures. Programs built with -D_FILE_OFFSET_BITS=64 call the *64
+// names (open64, pread64, fstat64, ...), so those are wrapped and
+// reported on their own too. newfstatat has no libc wrapper; it is what
+// fstatat and fstatat64 call. Only calls that go through the dynamic
+// symbol are seen: libc calling itself (printf ending in write, say) and
+// raw syscall(2) or inline syscalls are missed, and so are calls made
+// before the library is loaded. Times are wall clock around the wrapper,
+// where strace -c reports system time.
+//
+// The table is written when the process exits normally, when SIGINT or
+// SIGTERM stops it and whenever it gets SIGUSR2, but the signals are
+// only taken over if they are still at their default action when the
+// library loads. A process that ends in _exit, in SIGKILL or another
+// fatal signal, or through handlers of its own that never call exit
+// prints nothing; send it SIGUSR2 first. Like any handled signal,
+// SIGUSR2 cuts short a sleep the process is in.
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// X(return type, name, parameters, arguments) for every wrapper with a
+// fixed parameter list, one table per family. The open and fcntl
+// families take a variable one and have tables of their own further down.
+#define FILE_CALLS(X) \
+    X(ssize_t, read, (int fd, void *buf, size_t n), (fd, buf, n)) \
+    X(ssize_t, write, (int fd, const void *buf, size_t n), (fd, buf, n)) \
+    X(ssize_t, readv, (int fd, const struct iovec *iov, int n), \
+      (fd, iov, n)) \
+    X(ssize_t, writev, (int fd, const struct iovec *iov, int n), \
+      (fd, iov, n)) \
+    X(ssize_t, pread, (int fd, void *buf, size_t n, off_t off), \
+      (fd, buf, n, off)) \
+    X(ssize_t, pread64, (int fd, void *buf, size_t n, off64_t off), \
+      (fd, buf, n, off)) \
+    X(ssize_t, pwrite, (int fd, const void *buf, size_t n, off_t off), \
+      (fd, buf, n, off)) \
+    X(ssize_t, pwrite64, (int fd, const void *buf, size_t n, off64_t off), \
+      (fd, buf, n, off)) \
+    X(int, close, (int fd), (fd)) \
+    X(off_t, lseek, (int fd, off_t off, int whence), (fd, off, whence)) \
+    X(off64_t, lseek64, (int fd, off64_t off, int whence), \
+      (fd, off, whence)) \
+    X(int, ftruncate, (int fd, off_t len), (fd, len)) \
+    X(int, ftruncate64, (int fd, off64_t len), (fd, len)) \
+    X(int, stat, (const char *path, struct stat *st), (path, st)) \
+    X(int, stat64, (const char *path, struct stat64 *st), (path, st)) \
+    X(int, lstat, (const char *path, struct stat *st), (path, st)) \
+    X(int, lstat64, (const char *path, struct stat64 *st), (path, st)) \
+    X(int, fstat, (int fd, struct stat *st), (fd, st)) \
+    X(int, fstat64, (int fd, struct stat64 *st), (fd, st)) \
+    X(int, fstatat, (int dir, const char *path, struct stat *st, \
+                     int flags), (dir, path, st, flags)) \
+    X(int, fstatat64, (int dir, const char *path, struct stat64 *st, \
+                       int flags), (dir, path, st, flags)) \
+    X(int, statx, (int dir, const char *path, int flags, unsigned int mask, \
+                   struct statx *st), (dir, path, flags, mask, st)) \
+    X(int, access, (const char *path, int mode), (path, mode)) \
+    X(int, unlink, (const char *path), (path)) \
+    X(int, dup, (int fd), (fd)) \
+    X(int, dup2, (int fd, int fd2), (fd, fd2)) \
+    X(int, pipe, (int fds[2]), (fds)) \
+    X(int, fsync, (int fd), (fd))
+
+// glibc passes socket addresses as transparent unions under _GNU_SOURCE,
+// so the wrappers have to be declared with its types
+#define NET_CALLS(X) \
+    X(int, socket, (int domain, int type, int protocol), \
+      (domain, type, protocol)) \
+    X(int, socketpair, (int domain, int type, int protocol, int fds[2]), \
+      (domain, type, protocol, fds)) \
+    X(int, bind, (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len), \
+      (fd, addr, len)) \
+    X(int, listen, (int fd, int backlog), (fd, backlog)) \
+    X(int, connect, (int fd, __CONST_SOCKADDR_ARG addr, socklen_t len), \
+      (fd, addr, len)) \
+    X(int, accept, (int fd, __SOCKADDR_ARG addr, socklen_t *len), \
+      (fd, addr, len)) \
+    X(int, accept4, (int fd, __SOCKADDR_ARG addr, socklen_t *len, \
+                     int flags), (fd, addr, len, flags)) \
+    X(ssize_t, send, (int fd, const void *buf, size_t n, int flags), \
+      (fd, buf, n, flags)) \
+    X(ssize_t, recv, (int fd, void *buf, size_t n, int flags), \
+      (fd, buf, n, flags)) \
+    X(ssize_t, sendto, (int fd, const void *buf, size_t n, int flags, \
+                        __CONST_SOCKADDR_ARG addr, socklen_t len), \
+      (fd, buf, n, flags, addr, len)) \
+    X(ssize_t, recvfrom, (int fd, void *buf, size_t n, int flags, \
+                          __SOCKADDR_ARG addr, socklen_t *len), \
+      (fd, buf, n, flags, addr, len)) \
+    X(ssize_t, sendmsg, (int fd, const struct msghdr *msg, int flags), \
+      (fd, msg, flags)) \
+    X(ssize_t, recvmsg, (int fd, struct msghdr *msg, int flags), \
+      (fd, msg, flags)) \
+    X(int, shutdown, (int fd, int how), (fd, how)) \
+    X(int, setsockopt, (int fd, int level, int name, const void *val, \
+                        socklen_t len), (fd, level, name, val, len)) \
+    X(int, getsockopt, (int fd, int level, int name, void *val, \
+                        socklen_t *len), (fd, level, name, val, len))
+
+#define EVENT_CALLS(X) \
+    X(int, poll, (struct pollfd *fds, nfds_t n, int timeout), \
+      (fds, n, timeout)) \
+    X(int, ppoll, (struct pollfd *fds, nfds_t n, \
+                   const struct timespec *timeout, const sigset_t *mask), \
+      (fds, n, timeout, mask)) \
+    X(int, select, (int n, fd_set *rfds, fd_set *wfds, fd_set *efds, \
+                    struct timeval *timeout), (n, rfds, wfds, efds, timeout)) \
+    X(int, pselect, (int n, fd_set *rfds, fd_set *wfds, fd_set *efds, \
+                     const struct timespec *timeout, const sigset_t *mask), \
+      (n, rfds, wfds, efds, timeout, mask)) \
+    X(int, epoll_create1, (int flags), (flags)) \
+    X(int, epoll_ctl, (int epfd, int op, int fd, struct epoll_event *ev), \
+      (epfd, op, fd, ev)) \
+    X(int, epoll_wait, (int epfd, struct epoll_event *evs, int n, \
+                        int timeout), (epfd, evs, n, timeout)) \
+    X(int, epoll_pwait, (int epfd, struct epoll_event *evs, int n, \
+                         int timeout, const sigset_t *mask), \
+      (epfd, evs, n, timeout, mask))
+
+#define MEMORY_CALLS(X) \
+    X(void *, mmap, (void *addr, size_t len, int prot, int flags, int fd, \
+                     off_t off), (addr, len, prot, flags, fd, off)) \
+    X(void *, mmap64, (void *addr, size_t len, int prot, int flags, int fd, \
+                       off64_t off), (addr, len, prot, flags, fd, off)) \
+    X(int, munmap, (void *addr, size_t len), (addr, len)) \
+    X(int, mprotect, (void *addr, size_t len, int prot), (addr, len, prot))
+
+#define PROCESS_CALLS(X) \
+    X(pid_t, getpid, (void), ()) \
+    X(pid_t, getppid, (void), ()) \
+    X(uid_t, getuid, (void), ()) \
+    X(uid_t, geteuid, (void), ()) \
+    X(pid_t, fork, (void), ()) \
+    X(int, execve, (const char *path, char *const argv[], \
+                    char *const envp[]), (path, argv, envp)) \
+    X(pid_t, waitpid, (pid_t pid, int *status, int options), \
+      (pid, status, options)) \
+    X(int, kill, (pid_t pid, int sig), (pid, sig)) \
+    X(int, nanosleep, (const struct timespec *req, struct timespec *rem), \
+      (req, rem))
+
+#define SYSCALL_TABLE(X) \
+    FILE_CALLS(X) NET_CALLS(X) EVENT_CALLS(X) MEMORY_CALLS(X) \
+    PROCESS_CALLS(X)
+
+// X(name, parameters before flags, arguments before flags). The mode
+// after the flags is only there if they ask for a new file.
+#define OPEN_TABLE(X) \
+    X(open, (const char *path), (path)) \
+    X(open64, (const char *path), (path)) \
+    X(openat, (int dir, const char *path), (dir, path)) \
+    X(openat64, (int dir, const char *path), (dir, path))
+
+// X(name, parameters up to the request, arguments up to it). The
+// optional argument after the request is an int or a pointer depending on the request,
+// and is passed on as a pointer either way, as the kernel reads it.
+#define CONTROL_TABLE(X) \
+    X(fcntl, (int fd, int req), (fd, req)) \
+    X(fcntl64, (int fd, int req), (fd, req)) \
+    X(ioctl, (int fd, unsigned long req), (fd, req))
+
+#define PROF_UNPACK(...) __VA_ARGS__
+
+#define PROF_ID(ret, name, params, args) PROF_##name,
+#define PROF_VARARG_ID(name, params, args) PROF_##name,
+enum {
+    SYSCALL_TABLE(PROF_ID)
+    OPEN_TABLE(PROF_VARARG_ID)
+    CONTROL_TABLE(PROF_VARARG_ID)
+    NUM_PROF
+};
+
+#define PROF_NAME(ret, name, params, args) #name,
+#define PROF_VARARG_NAME(name, params, args) #name,
+static const char *prof_names[NUM_PROF] = {
+    SYSCALL_TABLE(PROF_NAME)
+    OPEN_TABLE(PROF_VARARG_NAME)
+    CONTROL_TABLE(PROF_VARARG_NAME)
+};
+
+// Updated atomically, so threads can make calls at the same time
+static unsigned long prof_calls[NUM_PROF];
+static unsigned long prof_errors[NUM_PROF];
+static unsigned long prof_ns[NUM_PROF];
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// Looks up the definition of name that this library hides.
+static void *resolve(const char *name) {
+    void *sym = dlsym(RTLD_NEXT, name);
+    if (!sym) {
+        fprintf(stderr, "sysprof: cannot find %s\n", name);
+        abort();
+    }
+    return sym;
+}
+
+static void record(int id, long start, int failed) {
+    __atomic_fetch_add(&prof_ns[id], now_ns() - start, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&prof_calls[id], 1, __ATOMIC_RELAXED);
+    if (failed) {
+        __atomic_fetch_add(&prof_errors[id], 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Every wrapper fails by returning -1 (MAP_FAILED for mmap). The real
+// function is looked up on first use; racing threads find the same one.
+#define PROF_WRAP(ret, name, params, args) \
+    ret name params { \
+        static ret (*real) params; \
+        if (!real) { \
+            real = (ret (*) params) resolve(#name); \
+        } \
+        long start = now_ns(); \
+        ret result = real args; \
+        int saved_errno = errno; \
+        record(PROF_##name, start, result == (ret) -1); \
+        errno = saved_errno; \
+        return result; \
+    }
+
+SYSCALL_TABLE(PROF_WRAP)
+
+static mode_t open_mode(int flags, va_list ap) {
+    // O_TMPFILE includes O_DIRECTORY, so test for every bit of it
+    int new_file = (flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE;
+    return new_file ? va_arg(ap, mode_t) : 0;
+}
+
+#define PROF_OPEN_WRAP(name, params, args) \
+    int name(PROF_UNPACK params, int flags, ...) { \
+        static int (*real)(PROF_UNPACK params, int, ...); \
+        if (!real) { \
+            real = (int (*)(PROF_UNPACK params, int, ...)) resolve(#name); \
+        } \
+        va_list ap; \
+        va_start(ap, flags); \
+        mode_t mode = open_mode(flags, ap); \
+        va_end(ap); \
+        long start = now_ns(); \
+        int fd = real(PROF_UNPACK args, flags, mode); \
+        int saved_errno = errno; \
+        record(PROF_##name, start, fd == -1); \
+        errno = saved_errno; \
+        return fd; \
+    }
+
+OPEN_TABLE(PROF_OPEN_WRAP)
+
+#define PROF_CONTROL_WRAP(name, params, args) \
+    int name(PROF_UNPACK params, ...) { \
+        static int (*real)(PROF_UNPACK params, ...); \
+        if (!real) { \
+            real = (int (*)(PROF_UNPACK params, ...)) resolve(#name); \
+        } \
+        va_list ap; \
+        va_start(ap, req); \
+        void *arg = va_arg(ap, void *); \
+        va_end(ap); \
+        long start = now_ns(); \
+        int result = real(PROF_UNPACK args, arg); \
+        int saved_errno = errno; \
+        record(PROF_##name, start, result == -1); \
+        errno = saved_errno; \
+        return result; \
+    }
+
+CONTROL_TABLE(PROF_CONTROL_WRAP)
+
+// Children forked without an exec inherit the counts, so only the
+// process that loaded the library reports them, as with strace -c
+// without -f. Our own getpid, open, write and close calls go around the
+// counting ones.
+static pid_t loader_pid;
+static pid_t (*raw_getpid)(void);
+static int (*raw_open)(const char *, int, ...);
+static ssize_t (*raw_write)(int, const void *, size_t);
+static int (*raw_close)(int);
+static const char *out_name;
+
+// The report is formatted by hand into a buffer on the caller's stack,
+// so the signal handlers can build one while the destructor or another
+// handler is building its own.
+typedef struct {
+    char buf[(NUM_PROF + 4) * 96];
+    size_t len;
+} report;
+
+// Appends str, dropping whatever does not fit.
+static void put_str(report *r, const char *str) {
+    while (*str && r->len < sizeof(r->buf)) {
+        r->buf[r->len++] = *str++;
+    }
+}
+
+// Appends val / 10^decimals with that many decimals, right aligned in
+// width characters.
+static void put_num(report *r, unsigned long val, int decimals, int width) {
+    char digits[32];
+    int n = 0;
+    do {
+        digits[n++] = '0' + val % 10;
+        val /= 10;
+        if (n == decimals) {
+            digits[n++] = '.';
+        }
+    } while (val || (decimals && n <= decimals + 1));
+    char field[64];
+    int len = 0;
+    while (len + n < width) {
+        field[len++] = ' ';
+    }
+    while (n) {
+        field[len++] = digits[--n];
+    }
+    field[len] = '\0';
+    put_str(r, field);
+}
+
+// Appends count as a column, left blank for 0 like strace's errors.
+static void put_count(report *r, unsigned long count, int width) {
+    if (count) {
+        put_num(r, count, 0, width);
+        return;
+    }
+    for (int i = 0; i < width; i++) {
+        put_str(r, " ");
+    }
+}
+
+// Appends a row: % time, seconds, usecs/call, calls, errors, name.
+static void put_row(report *r, unsigned long ns, unsigned long total_ns,
+                    unsigned long calls, unsigned long errors,
+                    const char *name) {
+    unsigned long hundredths = total_ns
+                               ? (unsigned long) (10000.0 * ns / total_ns + 0.5)
+                               : 0;
+    put_num(r, hundredths, 2, 6);
+    put_str(r, " ");
+    put_num(r, (ns + 500) / 1000, 6, 11);
+    put_str(r, " ");
+    if (name) {
+        put_num(r, ns / 1000 / calls, 0, 11);
+    } else {
+        put_count(r, 0, 11);
+    }
+    put_str(r, " ");
+    put_num(r, calls, 0, 9);
+    put_str(r, " ");
+    put_count(r, errors, 9);
+    put_str(r, " ");
+    put_str(r, name ? name : "total");
+    put_str(r, "\n");
+}
+
+// Writes the table built from the counts so far. It is also run from
+// signal handlers, so it only formats by hand and makes raw calls, no
+// stdio or malloc.
+static void write_report(void) {
+    if (raw_getpid() != loader_pid) {
+        return;
+    }
+    unsigned long calls[NUM_PROF], errors[NUM_PROF], ns[NUM_PROF];
+    for (int id = 0; id < NUM_PROF; id++) {
+        calls[id] = __atomic_load_n(&prof_calls[id], __ATOMIC_RELAXED);
+        errors[id] = __atomic_load_n(&prof_errors[id], __ATOMIC_RELAXED);
+        ns[id] = __atomic_load_n(&prof_ns[id], __ATOMIC_RELAXED);
+    }
+    // most time first, like strace -c
+    int order[NUM_PROF];
+    int num = 0;
+    unsigned long total_ns = 0, total_calls = 0, total_errors = 0;
+    for (int id = 0; id < NUM_PROF; id++) {
+        if (!calls[id]) {
+            continue;
+        }
+        int k = num++;
+        while (k > 0 && ns[order[k - 1]] < ns[id]) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = id;
+        total_ns += ns[id];
+        total_calls += calls[id];
+        total_errors += errors[id];
+    }
+
+    report r;
+    r.len = 0;
+    const char *rule = "------ ----------- ----------- --------- ---------"
+                       " ----------------\n";
+    put_str(&r, "% time     seconds  usecs/call     calls    errors"
+                " syscall\n");
+    put_str(&r, rule);
+    for (int k = 0; k < num; k++) {
+        int id = order[k];
+        put_row(&r, ns[id], total_ns, calls[id], errors[id], prof_names[id]);
+    }
+    put_str(&r, rule);
+    // the total row is 100% of whatever was seen, and 0 if nothing was
+    put_row(&r, total_ns, num ? total_ns : 0, total_calls, total_errors,
+            NULL);
+
+    int fd = STDERR_FILENO;
+    if (out_name) {
+        fd = raw_open(out_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                      0644);
+        if (fd == -1) {
+            fd = STDERR_FILENO;
+        }
+    }
+    for (size_t done = 0; done < r.len;) {
+        ssize_t n = raw_write(fd, r.buf + done, r.len - done);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        done += n;
+    }
+    if (fd != STDERR_FILENO) {
+        raw_close(fd);
+    }
+}
+
+static void on_dump(int sig) {
+    (void) sig;
+    int saved_errno = errno;
+    write_report();
+    errno = saved_errno;
+}
+
+// Reports, then lets the signal stop the process as it would have.
+static void on_stop(int sig) {
+    write_report();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// Takes over sig unless the process was started with it ignored or
+// handled (nohup, say).
+static void catch_signal(int sig, void (*handler)(int)) {
+    struct sigaction old;
+    if (sigaction(sig, NULL, &old) == -1 || old.sa_handler != SIG_DFL) {
+        return;
+    }
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sigemptyset(&sa.sa_mask);
+    sa.sa_handler = handler;
+    sa.sa_flags = SA_RESTART;
+    sigaction(sig, &sa, NULL);
+}
+
+__attribute__((constructor))
+static void sysprof_init(void) {
+    raw_getpid = (pid_t (*)(void)) resolve("getpid");
+    raw_open = (int (*)(const char *, int, ...)) resolve("open");
+    raw_write = (ssize_t (*)(int, const void *, size_t)) resolve("write");
+    raw_close = (int (*)(int)) resolve("close");
+    out_name = getenv("SYSPROF_OUT");
+    loader_pid = raw_getpid();
+    catch_signal(SIGINT, on_stop);
+    catch_signal(SIGTERM, on_stop);
+    catch_signal(SIGUSR2, on_dump);
+}
+
+__attribute__((destructor))
+static void sysprof_report(void) {
+    write_report();
+}
@@ -18,67 +18,180 @@
 
 #include "myshell.h"
 
-#define MAX_PROCS 128
-
 typedef struct {
     pid_t pid;
     int status;
     int exit_status;
+    int live_idx; // position in live while not reaped
 } proc_status_t;
 
 enum state { EXITED, RUNNING, TERMINATING };
 
-proc_status_t* procs[MAX_PROCS] = { 0 };
-pid_t proc_idx = 0;
+// every process started, in order, for info. grows by doubling
+proc_status_t* procs = NULL;
+int proc_idx = 0;
+int procs_cap = 0;
+
+// indices into procs of the processes not reaped yet. a reaped process
+// gives its slot to the last one, so this only holds what info has to
+// poll and quit has to stop
+int* live = NULL;
+int num_live = 0;
+int live_cap = 0;
+
+// pid -> index into procs for the live processes, open addressing with
+// linear probing, -1 for an empty slot. kept at most half full
+int* pid_table = NULL;
+int pid_table_cap = 0;
 
 // func declaration to avoid compiler warning
 int kill(pid_t pid, int sig);
 
+unsigned int hash_pid(pid_t pid) {
+    return (unsigned int) pid * 2654435761u;
+}
+
+// returns the slot of pid in pid_table, or the empty slot it would go in
+int pid_slot(pid_t pid) {
+    unsigned int mask = pid_table_cap - 1;
+    unsigned int i = hash_pid(pid) & mask;
+    while (pid_table[i] != -1 && procs[pid_table[i]].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return (int) i;
+}
+
+void index_pid(int idx) {
+    if (2 * (num_live + 1) > pid_table_cap) {
+        // rebuild from the live processes, which are all that is in it
+        pid_table_cap = pid_table_cap ? 2 * pid_table_cap : 64;
+        pid_table = (int*) realloc(pid_table, pid_table_cap * sizeof(int));
+        for (int i = 0; i < pid_table_cap; ++i) {
+            pid_table[i] = -1;
+        }
+        for (int i = 0; i < num_live; ++i) {
+            pid_table[pid_slot(procs[live[i]].pid)] = live[i];
+        }
+    }
+    pid_table[pid_slot(procs[idx].pid)] = idx;
+}
+
+// removes pid, shifting back any later entry of its probe run that
+// would otherwise no longer be found
+void unindex_pid(pid_t pid) {
+    unsigned int mask = pid_table_cap - 1;
+    unsigned int i = pid_slot(pid);
+    if (pid_table[i] == -1) {
+        return;
+    }
+    unsigned int j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (pid_table[j] == -1) {
+            break;
+        }
+        unsigned int home = hash_pid(procs[pid_table[j]].pid) & mask;
+        // j can fill the hole at i unless its home lies in (i, j]
+        if ((i < j) ? (home <= i || home > j) : (home <= i && home > j)) {
+            pid_table[i] = pid_table[j];
+            i = j;
+        }
+    }
+    pid_table[i] = -1;
+}
+
+// returns the process with this pid that has not been reaped, or NULL
+proc_status_t* find_live(pid_t pid) {
+    if (!pid_table_cap) {
+        return NULL;
+    }
+    int idx = pid_table[pid_slot(pid)];
+    return idx == -1 ? NULL : &procs[idx];
+}
+
+// records a new process, returns its index in procs
+int add_proc(pid_t pid, int status) {
+    if (proc_idx == procs_cap) {
+        procs_cap = procs_cap ? 2 * procs_cap : 64;
+        procs = (proc_status_t*) realloc(procs, procs_cap * sizeof(proc_status_t));
+    }
+    int idx = proc_idx++;
+    procs[idx].pid = pid;
+    procs[idx].status = status;
+    procs[idx].exit_status = 0;
+    procs[idx].live_idx = -1;
+    if (status != EXITED) {
+        if (num_live == live_cap) {
+            live_cap = live_cap ? 2 * live_cap : 64;
+            live = (int*) realloc(live, live_cap * sizeof(int));
+        }
+        // index before counting it live, a rebuild adds it here
+        index_pid(idx);
+        procs[idx].live_idx = num_live;
+        live[num_live++] = idx;
+    }
+    return idx;
+}
+
+// marks proc exited once it has been waited for
+void reap(proc_status_t* proc) {
+    proc->status = EXITED;
+    unindex_pid(proc->pid);
+    int last = live[--num_live];
+    live[proc->live_idx] = last;
+    procs[last].live_idx = proc->live_idx;
+    proc->live_idx = -1;
+}
+
 void my_init(void) {
     // Initialize what you need here
 }
 
 void get_status(void) {
-    // update exited procs
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        pid_t status = waitpid(procs[i]->pid, &(procs[i]->exit_status), WNOHANG);
+    // update exited procs. reaping moves the last live proc into slot i,
+    // so walk backwards to visit each once
+    for (int i = num_live - 1; i >= 0; --i) {
+        proc_status_t* proc = &procs[live[i]];
+        pid_t status = waitpid(proc->pid, &(proc->exit_status), WNOHANG);
         // exited (zombie process) or error (child doesnt exist)
         if (status) {
-            procs[i]->status = EXITED;
+            reap(proc);
         }
     }
     // print out procs
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        printf("[%d] ", procs[i]->pid);
-        if (procs[i]->status == RUNNING) {
+    for (int i = 0; i < proc_idx; ++i) {
+        printf("[%d] ", procs[i].pid);
+        if (procs[i].status == RUNNING) {
             printf("Running\n");
             continue;
         }
-        if (procs[i]->status == TERMINATING) {
+        if (procs[i].status == TERMINATING) {
             printf("Terminating\n");
             continue;
         }
-        printf("Exited %d\n", WEXITSTATUS(procs[i]->exit_status));
+        printf("Exited %d\n", WEXITSTATUS(procs[i].exit_status));
     }
 }
 
 void wait_proc(int child_pid) {
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        if (procs[i]->pid == child_pid && (procs[i]->status == RUNNING || procs[i]->status == TERMINATING)) {
-            waitpid(child_pid, &(procs[i]->exit_status), WUNTRACED);
-            break;
-        }
+    proc_status_t* proc = find_live(child_pid);
+    if (!proc) {
+        return;
+    }
+    pid_t status = waitpid(child_pid, &(proc->exit_status), WUNTRACED);
+    // reap it now rather than at the next info, so its pid cannot be
+    // handed to a new child while it is still indexed
+    if (status == -1 || (status && !WIFSTOPPED(proc->exit_status))) {
+        reap(proc);
     }
 }
 
 void term_pid(int child_pid) {
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        if (procs[i]->pid == child_pid && procs[i]->status == RUNNING) {
-            // term pid here
-            procs[i]->status = TERMINATING;
-            kill(-child_pid, SIGTERM);
-            break;
-        }
+    proc_status_t* proc = find_live(child_pid);
+    if (proc && proc->status == RUNNING) {
+        // term pid here
+        proc->status = TERMINATING;
+        kill(-child_pid, SIGTERM);
     }
 }
 
@@ -181,11 +294,9 @@ void my_process_command(size_t num_tokens, char **tokens) {
             printf("%s does not exist\n", tokens[redir_idx + 1]);
             return;
         }
-        proc_status_t* proc = (proc_status_t*) malloc(sizeof(proc_status_t));
-        proc->pid = exec_command(0, tokens);
-        proc->status = RUNNING;
-        printf("Child[%d] in background\n", proc->pid);
-        procs[proc_idx++] = proc;
+        pid_t child_pid = exec_command(0, tokens);
+        add_proc(child_pid, RUNNING);
+        printf("Child[%d] in background\n", child_pid);
         return;
     }
     // handle one or more chained tasks
@@ -207,10 +318,8 @@ void my_process_command(size_t num_tokens, char **tokens) {
             return;
         }
         // run the binary
-        proc_status_t* proc = (proc_status_t*) malloc(sizeof(proc_status_t));
-        proc->pid = exec_command(start, tokens);
-        proc->status = EXITED;
-        procs[proc_idx++] = proc;
+        int idx = add_proc(exec_command(start, tokens), EXITED);
+        proc_status_t* proc = &procs[idx];
         waitpid(proc->pid, &(proc->exit_status), WUNTRACED);
         if (!isFinalCommand && proc->exit_status != EXIT_SUCCESS) {
             printf("%s failed\n", tokens[start]);
@@ -221,22 +330,18 @@ void my_process_command(size_t num_tokens, char **tokens) {
 
 void my_quit(void) {
     // sigterm to all
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        if (procs[i]->status == RUNNING || procs[i]->status == TERMINATING) {
-            kill(-procs[i]->pid, SIGTERM);
-            procs[i]->status = TERMINATING;
-        }
+    for (int i = 0; i < num_live; ++i) {
+        kill(-procs[live[i]].pid, SIGTERM);
+        procs[live[i]].status = TERMINATING;
     }
     // wait for all
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        if (procs[i]->status == TERMINATING) {
-            waitpid(procs[i]->pid, NULL, 0);
-        }
+    for (int i = 0; i < num_live; ++i) {
+        waitpid(procs[live[i]].pid, NULL, 0);
     }
     // Clean up function, called after "quit" is entered as a user command
-    for (int i = 0; i < (int) proc_idx; ++i) {
-        free(procs[i]);
-    }
+    free(procs);
+    free(live);
+    free(pid_table);
     printf("Goodbye!\n");
 }
 